@@ -3,19 +3,31 @@ echo Building Chess Engine...
 
 if not exist obj mkdir obj
 
+REM Generate the constant tables (attacks, magics, evaluation, Zobrist)
+gcc -Wall -Wextra -O2 -std=c99 tools/gentables.c -o obj/gentables.exe
+obj\gentables.exe > obj\tables.c
+gcc -Wall -Wextra -O2 -std=c99 -Isrc -c obj/tables.c -o obj/tables.o
+
 gcc -Wall -Wextra -O2 -std=c99 -c src/constants.c -o obj/constants.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/move.c -o obj/move.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/bitboard.c -o obj/bitboard.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/attackinfo.c -o obj/attackinfo.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/cpu.c -o obj/cpu.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/board.c -o obj/board.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/movegen.c -o obj/movegen.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/movepick.c -o obj/movepick.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/see.c -o obj/see.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/perft.c -o obj/perft.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/evaluation.c -o obj/evaluation.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/search.c -o obj/search.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/ybw.c -o obj/ybw.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/uci.c -o obj/uci.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/book.c -o obj/book.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/transposition.c -o obj/transposition.o
+gcc -Wall -Wextra -O2 -std=c99 -c src/zobrist.c -o obj/zobrist.o
 gcc -Wall -Wextra -O2 -std=c99 -c src/main.c -o obj/main.o
 
-gcc obj/*.o -o chess_engine.exe
+gcc obj/*.o -pthread -o chess_engine.exe
 
 REM Wait to finish compilation
 echo Sorting dependencies...
@@ -0,0 +1,80 @@
+#include "attackinfo.h"
+#include "bitboard.h"
+
+// Fill the attack maps of one color, recording each piece's own attacks
+static void add_attacks(const Board* board, AttackInfo* ai, Color c) {
+    Bitboard occupied = board->occupied;
+    Bitboard pawns = board->pieces[c][PAWN];
+    Bitboard total;
+
+    ai->by_piece[c][PAWN] = (c == WHITE) ? (shift_northeast(pawns) | shift_northwest(pawns))
+                                         : (shift_southeast(pawns) | shift_southwest(pawns));
+    total = ai->by_piece[c][PAWN];
+
+    for (PieceType pt = KNIGHT; pt <= QUEEN; pt++) {
+        Bitboard pieces = board->pieces[c][pt];
+        Bitboard attacked = 0;
+        while (pieces) {
+            Square sq = pop_lsb(&pieces);
+            Bitboard attacks;
+            switch (pt) {
+                case KNIGHT: attacks = knight_attacks[sq]; break;
+                case BISHOP: attacks = bishop_attacks(sq, occupied); break;
+                case ROOK:   attacks = rook_attacks(sq, occupied); break;
+                default:     attacks = bishop_attacks(sq, occupied) | rook_attacks(sq, occupied); break;
+            }
+            ai->piece_attacks[sq] = attacks;
+            attacked |= attacks;
+        }
+        ai->by_piece[c][pt] = attacked;
+        total |= attacked;
+    }
+
+    ai->by_piece[c][KING] = king_attacks[lsb(board->pieces[c][KING])];
+    ai->by_color[c] = total | ai->by_piece[c][KING];
+}
+
+void attack_info_init(const Board* board, AttackInfo* ai) {
+    Color us = board->side_to_move;
+    Color them = color_opposite(us);
+    Square king_sq = lsb(board->pieces[us][KING]);
+    Bitboard queens = board->pieces[them][QUEEN];
+
+    add_attacks(board, ai, them);
+    ai->complete = 0;
+
+    ai->king_sq = king_sq;
+    ai->checkers = board_attackers_to(board, king_sq, board->occupied) & board->by_color[them];
+    ai->pinned = 0;
+
+    // Enemy sliders on an empty-board line to the king pin a lone own blocker
+    Bitboard snipers = (bishop_attacks(king_sq, 0) & (board->pieces[them][BISHOP] | queens)) |
+                       (rook_attacks(king_sq, 0) & (board->pieces[them][ROOK] | queens));
+    while (snipers) {
+        Square sniper = pop_lsb(&snipers);
+        Bitboard blockers = between_bb[king_sq][sniper] & board->occupied;
+        if (blockers && !(blockers & (blockers - 1))) {
+            ai->pinned |= blockers & board->by_color[us];
+        }
+    }
+}
+
+void attack_info_complete(const Board* board, AttackInfo* ai) {
+    if (ai->complete) return;
+    add_attacks(board, ai, board->side_to_move);
+    ai->complete = 1;
+}
+
+Bitboard attack_info_king_danger(const Board* board, const AttackInfo* ai) {
+    Color them = color_opposite(board->side_to_move);
+    Bitboard danger = ai->by_color[them];
+
+    // The king cannot retreat along the line of a slider checking it
+    Bitboard sliders = ai->checkers & (board->pieces[them][BISHOP] | board->pieces[them][ROOK] |
+                                       board->pieces[them][QUEEN]);
+    while (sliders) {
+        Square sq = pop_lsb(&sliders);
+        danger |= line_bb[ai->king_sq][sq] ^ square_bb[sq];
+    }
+    return danger;
+}
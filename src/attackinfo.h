@@ -0,0 +1,31 @@
+#ifndef ATTACKINFO_H
+#define ATTACKINFO_H
+
+#include "constants.h"
+#include "board.h"
+
+// Attack maps for one position. Search computes it once per node and hands
+// it to move generation, castling legality and evaluation. Move generation
+// only needs the enemy's maps, so the side to move's maps are filled on
+// demand by attack_info_complete.
+typedef struct {
+    Bitboard by_piece[2][6];     // Squares attacked by each color's pieces of one type
+    Bitboard by_color[2];        // Squares attacked by each color
+    Bitboard piece_attacks[64];  // Attacks of the knight, bishop, rook or queen on a square
+    Square king_sq;              // Side to move's king
+    Bitboard checkers;           // Enemy pieces giving check
+    Bitboard pinned;             // Own pieces pinned to the king
+    int complete;                // Side to move's maps filled in as well
+} AttackInfo;
+
+// Checkers, pins and the enemy's attack maps
+void attack_info_init(const Board* board, AttackInfo* ai);
+
+// Add the side to move's attack maps (no-op if already present)
+void attack_info_complete(const Board* board, AttackInfo* ai);
+
+// Squares the side to move's king may not step to: enemy attacks plus the
+// squares behind the king on a checking slider's line
+Bitboard attack_info_king_danger(const Board* board, const AttackInfo* ai);
+
+#endif // ATTACKINFO_H
@@ -1,12 +1,11 @@
 #include "bitboard.h"
+#include "cpu.h"
+#include <string.h>
 
-// Pre-computed bitboards
-Bitboard rank_bb[8];
-Bitboard file_bb[8];
-Bitboard square_bb[64];
-Bitboard knight_attacks[64];
-Bitboard king_attacks[64];
-Bitboard pawn_attacks[2][64];
+#if !defined(CPU_GENERIC) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_X86_KERNELS
+#include <immintrin.h>
+#endif
 
 // Bitboard operations
 Bitboard set_bit(Bitboard bb, Square sq) {
@@ -21,15 +20,6 @@ int test_bit(Bitboard bb, Square sq) {
     return (bb & (1ULL << sq)) != 0;
 }
 
-int pop_count(Bitboard bb) {
-    int count = 0;
-    while (bb) {
-        count++;
-        bb &= bb - 1; // Clear least significant bit
-    }
-    return count;
-}
-
 Square lsb(Bitboard bb) {
     if (bb == 0) return A1; // Return A1 as default
     return (Square)__builtin_ctzll(bb);
@@ -46,6 +36,44 @@ Square pop_lsb(Bitboard* bb) {
     return sq;
 }
 
+// Slider attacks
+static Bitboard bishop_attacks_magic(Square sq, Bitboard occupied) {
+    const Magic* m = &bishop_magics[sq];
+    return bishop_attack_table[m->offset + (((occupied & m->mask) * m->magic) >> m->shift)];
+}
+
+static Bitboard rook_attacks_magic(Square sq, Bitboard occupied) {
+    const Magic* m = &rook_magics[sq];
+    return rook_attack_table[m->offset + (((occupied & m->mask) * m->magic) >> m->shift)];
+}
+
+#ifdef HAVE_X86_KERNELS
+__attribute__((target("bmi2")))
+static Bitboard bishop_attacks_pext(Square sq, Bitboard occupied) {
+    const Magic* m = &bishop_magics[sq];
+    return bishop_pext_table[m->offset + _pext_u64(occupied, m->mask)];
+}
+
+__attribute__((target("bmi2")))
+static Bitboard rook_attacks_pext(Square sq, Bitboard occupied) {
+    const Magic* m = &rook_magics[sq];
+    return rook_pext_table[m->offset + _pext_u64(occupied, m->mask)];
+}
+#endif
+
+// Kernel dispatch, set by init_bitboards from the detected CPU features
+int bitboard_popcnt = 0;
+Bitboard (*bishop_attacks)(Square sq, Bitboard occupied) = bishop_attacks_magic;
+Bitboard (*rook_attacks)(Square sq, Bitboard occupied) = rook_attacks_magic;
+static int use_pext = 0;
+
+const char* bitboard_kernel_string(void) {
+    static char buffer[64];
+    strcpy(buffer, bitboard_popcnt ? "popcount:popcnt" : "popcount:generic");
+    strcat(buffer, use_pext ? " sliders:pext" : " sliders:magic");
+    return buffer;
+}
+
 // Bitboard shifts
 Bitboard shift_north(Bitboard bb) {
     return bb << 8;
@@ -79,56 +107,21 @@ Bitboard shift_southwest(Bitboard bb) {
     return (bb >> 9) & ~FILE_H_BB;
 }
 
-// Initialize pre-computed bitboards
+// Select kernels from the detected CPU features
 void init_bitboards(void) {
-    // Initialize rank and file bitboards
-    rank_bb[0] = RANK_1_BB;
-    rank_bb[1] = RANK_2_BB;
-    rank_bb[2] = RANK_3_BB;
-    rank_bb[3] = RANK_4_BB;
-    rank_bb[4] = RANK_5_BB;
-    rank_bb[5] = RANK_6_BB;
-    rank_bb[6] = RANK_7_BB;
-    rank_bb[7] = RANK_8_BB;
-
-    file_bb[0] = FILE_A_BB;
-    file_bb[1] = FILE_B_BB;
-    file_bb[2] = FILE_C_BB;
-    file_bb[3] = FILE_D_BB;
-    file_bb[4] = FILE_E_BB;
-    file_bb[5] = FILE_F_BB;
-    file_bb[6] = FILE_G_BB;
-    file_bb[7] = FILE_H_BB;
-
-    // Initialize square bitboards
-    for (int i = 0; i < 64; i++) {
-        square_bb[i] = 1ULL << i;
+    cpu_detect();
+    bitboard_popcnt = 0;
+    bishop_attacks = bishop_attacks_magic;
+    rook_attacks = rook_attacks_magic;
+    use_pext = 0;
+#ifdef HAVE_X86_KERNELS
+    if (cpu_features.popcnt) {
+        bitboard_popcnt = 1;
     }
-
-    // Initialize knight attacks
-    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
-        Bitboard bb = square_bb[sq];
-        knight_attacks[sq] = 
-            shift_north(shift_northeast(bb)) | shift_north(shift_northwest(bb)) |  // 2 up, 1 left/right
-            shift_south(shift_southeast(bb)) | shift_south(shift_southwest(bb)) |  // 2 down, 1 left/right
-            shift_east(shift_northeast(bb)) | shift_east(shift_southeast(bb)) |    // 2 right, 1 up/down
-            shift_west(shift_northwest(bb)) | shift_west(shift_southwest(bb));     // 2 left, 1 up/down
+    if (cpu_features.bmi2) {
+        bishop_attacks = bishop_attacks_pext;
+        rook_attacks = rook_attacks_pext;
+        use_pext = 1;
     }
-
-    // Initialize king attacks
-    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
-        Bitboard bb = square_bb[sq];
-        king_attacks[sq] = 
-            shift_north(bb) | shift_south(bb) | shift_east(bb) | shift_west(bb) |
-            shift_northeast(bb) | shift_northwest(bb) | shift_southeast(bb) | shift_southwest(bb);
-    }
-
-    // Initialize pawn attacks
-    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
-        Bitboard bb = square_bb[sq];
-        // White pawn attacks (moving up)
-        pawn_attacks[WHITE][sq] = shift_northeast(bb) | shift_northwest(bb);
-        // Black pawn attacks (moving down)
-        pawn_attacks[BLACK][sq] = shift_southeast(bb) | shift_southwest(bb);
-    }
-} 
\ No newline at end of file
+#endif
+}
@@ -11,7 +11,6 @@ typedef uint64_t Bitboard;
 Bitboard set_bit(Bitboard bb, Square sq);
 Bitboard clear_bit(Bitboard bb, Square sq);
 int test_bit(Bitboard bb, Square sq);
-int pop_count(Bitboard bb);
 Square lsb(Bitboard bb);
 Square msb(Bitboard bb);
 Square pop_lsb(Bitboard* bb);
@@ -26,15 +25,65 @@ Bitboard shift_northwest(Bitboard bb);
 Bitboard shift_southeast(Bitboard bb);
 Bitboard shift_southwest(Bitboard bb);
 
-// Pre-computed bitboards
-extern Bitboard rank_bb[8];
-extern Bitboard file_bb[8];
-extern Bitboard square_bb[64];
-extern Bitboard knight_attacks[64];
-extern Bitboard king_attacks[64];
-extern Bitboard pawn_attacks[2][64];
+// Pre-computed bitboards (generated at build time by tools/gentables.c)
+extern const Bitboard rank_bb[8];
+extern const Bitboard file_bb[8];
+extern const Bitboard square_bb[64];
+extern const Bitboard knight_attacks[64];
+extern const Bitboard king_attacks[64];
+extern const Bitboard pawn_attacks[2][64];
+extern const Bitboard between_bb[64][64];  // Squares strictly between two aligned squares
+extern const Bitboard line_bb[64][64];     // Full line through two aligned squares (0 if not aligned)
 
-// Initialization
+// Slider lookup for one square. Both the magic and the PEXT index land in
+// the square's slice of its table, which starts at 'offset'.
+typedef struct {
+    Bitboard mask;      // Relevant occupancy (board edges excluded)
+    Bitboard magic;     // Multiplier mapping occupancy subsets to table indices
+    unsigned offset;    // Start of this square's slice of the attack tables
+    int shift;          // 64 - number of relevant occupancy bits
+} Magic;
+
+extern const Magic bishop_magics[64];
+extern const Magic rook_magics[64];
+extern const Bitboard bishop_attack_table[0x1480];   // Magic-indexed
+extern const Bitboard rook_attack_table[0x19000];
+extern const Bitboard bishop_pext_table[0x1480];     // PEXT-indexed
+extern const Bitboard rook_pext_table[0x19000];
+
+// Slider attacks (BMI2 PEXT lookups when available, magic bitboards otherwise)
+extern Bitboard (*bishop_attacks)(Square sq, Bitboard occupied);
+extern Bitboard (*rook_attacks)(Square sq, Bitboard occupied);
+
+// Set by init_bitboards when pop_count may use the POPCNT instruction
+extern int bitboard_popcnt;
+
+// Inlined into every caller. The startup choice is a well-predicted branch
+// instead of an indirect call; inline asm needs no popcnt target attribute
+// on the caller. Builds with -mpopcnt use the builtin directly.
+static inline int pop_count(Bitboard bb) {
+#if defined(__POPCNT__) && !defined(CPU_GENERIC)
+    return __builtin_popcountll(bb);
+#else
+#if !defined(CPU_GENERIC) && defined(__GNUC__) && defined(__x86_64__)
+    if (bitboard_popcnt) {
+        Bitboard count;
+        __asm__("popcnt %1, %0" : "=r"(count) : "r"(bb));
+        return (int)count;
+    }
+#endif
+    // Portable popcount (SWAR)
+    bb = bb - ((bb >> 1) & 0x5555555555555555ULL);
+    bb = (bb & 0x3333333333333333ULL) + ((bb >> 2) & 0x3333333333333333ULL);
+    bb = (bb + (bb >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return (int)((bb * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// Detect the CPU and select the kernels above (the tables need no setup)
 void init_bitboards(void);
 
+// Active kernel set, e.g. "popcount:popcnt sliders:pext"
+const char* bitboard_kernel_string(void);
+
 #endif // BITBOARD_H 
\ No newline at end of file
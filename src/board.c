@@ -1,11 +1,32 @@
 #include "board.h"
 #include "uci.h"
 #include "movegen.h"
+#include "zobrist.h"
+#include "transposition.h"
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdlib.h>
 #include <math.h>
+#ifdef HASH_DEBUG
+#include <assert.h>
+#endif
+
+// Rebuild occupancy and the mailbox from the piece bitboards
+static void board_update_occupancy(Board* board) {
+    board->occupied = 0;
+    memset(board->piece_on, NO_PIECE, sizeof(board->piece_on));
+    for (Color c = WHITE; c < COLOR_COUNT; c++) {
+        board->by_color[c] = 0;
+        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
+            Bitboard bb = board->pieces[c][pt];
+            board->by_color[c] |= bb;
+            while (bb) board->piece_on[pop_lsb(&bb)] = (uint8_t)pt;
+        }
+        board->occupied |= board->by_color[c];
+    }
+    board->empty = ~board->occupied;
+}
 
 // Initialize board to starting position
 void board_init(Board* board) {
@@ -23,21 +44,19 @@ void board_init(Board* board) {
     board->pieces[BLACK][ROOK]   = (1ULL << A8) | (1ULL << H8);
     board->pieces[BLACK][QUEEN]  = (1ULL << D8);
     board->pieces[BLACK][KING]   = (1ULL << E8);
-    board->occupied = 0;
-    for (Color c = WHITE; c < COLOR_COUNT; c++)
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-            board->occupied |= board->pieces[c][pt];
-    board->empty = ~board->occupied;
+    board_update_occupancy(board);
     board->side_to_move = WHITE;
     board->en_passant = A1;
     board->castling_rights = WHITE_KINGSIDE | WHITE_QUEENSIDE | BLACK_KINGSIDE | BLACK_QUEENSIDE;
     board->halfmove_clock = 0;
     board->fullmove_number = 1;
+    board->key = generate_hash(board);
 }
 
 // Parse FEN string and set board state
 void board_set_fen(Board* board, const char* fen) {
     board_init(board);
+    memset(board->pieces, 0, sizeof(board->pieces));
     const char* p = fen;
     Square sq = A8;
     // Piece placement
@@ -64,11 +83,7 @@ void board_set_fen(Board* board, const char* fen) {
         }
         p++;
     }
-    board->occupied = 0;
-    for (Color c = WHITE; c < COLOR_COUNT; c++)
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-            board->occupied |= board->pieces[c][pt];
-    board->empty = ~board->occupied;
+    board_update_occupancy(board);
     if (*p == ' ') p++;
     if (*p == 'w') board->side_to_move = WHITE;
     else if (*p == 'b') board->side_to_move = BLACK;
@@ -110,14 +125,16 @@ void board_set_fen(Board* board, const char* fen) {
             p++;
         }
     }
+    board->key = generate_hash(board);
 }
 
 void board_get_fen(const Board* board, char* fen) {
     char* p = fen;
-    for (Rank r = RANK_8; r >= RANK_1; r--) {
+    // Rank is an unsigned enum, so count down with an int
+    for (int r = RANK_8; r >= RANK_1; r--) {
         int empty_count = 0;
         for (File f = FILE_A; f <= FILE_H; f++) {
-            Square sq = make_square(f, r);
+            Square sq = make_square(f, (Rank)r);
             int found = 0;
             char piece_char = ' ';
             for (Color c = WHITE; c < COLOR_COUNT && !found; c++)
@@ -131,6 +148,7 @@ void board_get_fen(const Board* board, char* fen) {
                             case ROOK: piece_char = 'r'; break;
                             case QUEEN: piece_char = 'q'; break;
                             case KING: piece_char = 'k'; break;
+                            default: break;
                         }
                         if (c == WHITE) piece_char = toupper(piece_char);
                     }
@@ -163,79 +181,208 @@ void board_get_fen(const Board* board, char* fen) {
     sprintf(p, " %d %d", board->halfmove_clock, board->fullmove_number);
 }
 
+// Piece placement helpers keeping occupancy and the mailbox in sync
+static inline void put_piece(Board* board, Color color, PieceType piece, Square sq) {
+    board->pieces[color][piece] |= (1ULL << sq);
+    board->by_color[color] |= (1ULL << sq);
+    board->occupied |= (1ULL << sq);
+    board->piece_on[sq] = (uint8_t)piece;
+}
+
+static inline void remove_piece(Board* board, Color color, PieceType piece, Square sq) {
+    board->pieces[color][piece] &= ~(1ULL << sq);
+    board->by_color[color] &= ~(1ULL << sq);
+    board->occupied &= ~(1ULL << sq);
+    board->piece_on[sq] = NO_PIECE;
+}
+
+static inline void move_piece(Board* board, Color color, PieceType piece, Square from, Square to) {
+    Bitboard from_to = (1ULL << from) | (1ULL << to);
+    board->pieces[color][piece] ^= from_to;
+    board->by_color[color] ^= from_to;
+    board->occupied ^= from_to;
+    board->piece_on[from] = NO_PIECE;
+    board->piece_on[to] = (uint8_t)piece;
+}
+
+// HASH_DEBUG builds verify the incremental key against a full recompute
+#ifdef HASH_DEBUG
+static void check_key(const Board* board) {
+    assert(board->key == generate_hash(board));
+}
+#else
+#define check_key(board) ((void)0)
+#endif
+
+static inline void castle_rook_squares(Color color, uint8_t flags, Square* rook_from, Square* rook_to) {
+    if (flags == KING_CASTLE) {
+        *rook_from = (color == WHITE) ? H1 : H8;
+        *rook_to = (color == WHITE) ? F1 : F8;
+    } else {
+        *rook_from = (color == WHITE) ? A1 : A8;
+        *rook_to = (color == WHITE) ? D1 : D8;
+    }
+}
+
+// Castling rights kept when a move starts or ends on a square: moving a king
+// or rook, or capturing a rook, gives up the rights that depend on it
+static int castling_mask(Square sq) {
+    switch (sq) {
+        case A1: return ~WHITE_QUEENSIDE;
+        case H1: return ~WHITE_KINGSIDE;
+        case E1: return ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
+        case A8: return ~BLACK_QUEENSIDE;
+        case H8: return ~BLACK_KINGSIDE;
+        case E8: return ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
+        default: return ~0;
+    }
+}
+
+// Zobrist key of the position after move, without making it
+uint64_t board_key_after(const Board* board, Move move) {
+    Square from = move_from(move);
+    Square to = move_to(move);
+    PieceType piece = (PieceType)board->piece_on[from];
+    Color color = board->side_to_move;
+    Color enemy = color_opposite(color);
+
+    uint64_t key = board->key ^ zobrist_side ^ zobrist_pieces[color][piece][from];
+    if (is_en_passant(move)) {
+        key ^= zobrist_pieces[enemy][PAWN][(color == WHITE) ? to - 8 : to + 8];
+    } else if (is_capture(move)) {
+        key ^= zobrist_pieces[enemy][board->piece_on[to]][to];
+    }
+    key ^= zobrist_pieces[color][is_promotion(move) ? promotion_piece(move) : piece][to];
+    if (is_castle(move)) {
+        Square rook_from, rook_to;
+        castle_rook_squares(color, move_flags(move), &rook_from, &rook_to);
+        key ^= zobrist_pieces[color][ROOK][rook_from] ^ zobrist_pieces[color][ROOK][rook_to];
+    }
+    if (board->en_passant != A1) key ^= zobrist_ep[board->en_passant];
+    if (is_double_pawn_push(move)) key ^= zobrist_ep[(color == WHITE) ? from + 8 : from - 8];
+    int rights = board->castling_rights & castling_mask(from) & castling_mask(to);
+    return key ^ zobrist_castling[board->castling_rights] ^ zobrist_castling[rights];
+}
+
 void board_make_move(Board* board, Move move) {
     Square from = move_from(move);
     Square to = move_to(move);
     uint8_t flags = move_flags(move);
-    PieceType piece = PAWN;
+    PieceType piece = (PieceType)board->piece_on[from];
     Color color = board->side_to_move;
-    for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-        if (board->pieces[color][pt] & (1ULL << from)) { piece = pt; break; }
-    board->pieces[color][piece] &= ~(1ULL << from);
+    Color enemy = color_opposite(color);
+
+    // The child's key comes first so a TT_PREFETCH build can start loading its
+    // bucket while the board is updated
+    uint64_t key = board_key_after(board, move);
+    tt_prefetch(key);
+
+    // Save irreversible state for board_undo_move
+    BoardState* st = &board->history[board->ply++ & (MAX_GAME_PLY - 1)];
+    st->captured = NO_PIECE;
+    st->en_passant = board->en_passant;
+    st->castling_rights = board->castling_rights;
+    st->halfmove_clock = board->halfmove_clock;
+    st->key = board->key;
+
     if (is_capture(move)) {
         if (is_en_passant(move)) {
             Square captured_sq = (color == WHITE) ? (Square)(to - 8) : (Square)(to + 8);
-            board->pieces[color_opposite(color)][PAWN] &= ~(1ULL << captured_sq);
+            remove_piece(board, enemy, PAWN, captured_sq);
+            st->captured = PAWN;
         } else {
-            for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-                if (board->pieces[color_opposite(color)][pt] & (1ULL << to)) {
-                    board->pieces[color_opposite(color)][pt] &= ~(1ULL << to);
-                    break;
-                }
+            st->captured = (PieceType)board->piece_on[to];
+            remove_piece(board, enemy, st->captured, to);
         }
     }
-    if (is_promotion(move)) piece = promotion_piece(move);
-    board->pieces[color][piece] |= (1ULL << to);
+    if (is_promotion(move)) {
+        remove_piece(board, color, PAWN, from);
+        put_piece(board, color, promotion_piece(move), to);
+    } else {
+        move_piece(board, color, piece, from, to);
+    }
     if (is_castle(move)) {
         Square rook_from, rook_to;
-        if (flags == KING_CASTLE) {
-            rook_from = (color == WHITE) ? H1 : H8;
-            rook_to = (color == WHITE) ? F1 : F8;
-        } else {
-            rook_from = (color == WHITE) ? A1 : A8;
-            rook_to = (color == WHITE) ? D1 : D8;
-        }
-        board->pieces[color][ROOK] &= ~(1ULL << rook_from);
-        board->pieces[color][ROOK] |= (1ULL << rook_to);
+        castle_rook_squares(color, flags, &rook_from, &rook_to);
+        move_piece(board, color, ROOK, rook_from, rook_to);
     }
-    board->occupied = 0;
-    for (Color c = WHITE; c < COLOR_COUNT; c++)
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-            board->occupied |= board->pieces[c][pt];
     board->empty = ~board->occupied;
     if (is_double_pawn_push(move)) {
         board->en_passant = (color == WHITE) ? (Square)(from + 8) : (Square)(from - 8);
     } else {
         board->en_passant = A1;
     }
-    if (piece == KING) {
-        if (color == WHITE) board->castling_rights &= ~(WHITE_KINGSIDE | WHITE_QUEENSIDE);
-        else board->castling_rights &= ~(BLACK_KINGSIDE | BLACK_QUEENSIDE);
-    } else if (piece == ROOK) {
-        if (color == WHITE) {
-            if (from == A1) board->castling_rights &= ~WHITE_QUEENSIDE;
-            if (from == H1) board->castling_rights &= ~WHITE_KINGSIDE;
-        } else {
-            if (from == A8) board->castling_rights &= ~BLACK_QUEENSIDE;
-            if (from == H8) board->castling_rights &= ~BLACK_KINGSIDE;
-        }
-    }
-    // Lose castling rights if rook captured
-    if (is_capture(move)) {
-        if (to == A1) board->castling_rights &= ~WHITE_QUEENSIDE;
-        if (to == H1) board->castling_rights &= ~WHITE_KINGSIDE;
-        if (to == A8) board->castling_rights &= ~BLACK_QUEENSIDE;
-        if (to == H8) board->castling_rights &= ~BLACK_KINGSIDE;
-    }
+    board->castling_rights &= castling_mask(from) & castling_mask(to);
+    board->key = key;
     if (piece == PAWN || is_capture(move)) board->halfmove_clock = 0;
     else board->halfmove_clock++;
     if (board->side_to_move == BLACK) board->fullmove_number++;
-    board->side_to_move = color_opposite(board->side_to_move);
-    // Debug printing removed for performance
+    board->side_to_move = enemy;
+    check_key(board);
 }
 
+// Take back the last move made with board_make_move
 void board_undo_move(Board* board, Move move) {
-    // Not implemented in this simple version
+    const BoardState* st = &board->history[--board->ply & (MAX_GAME_PLY - 1)];
+    Square from = move_from(move);
+    Square to = move_to(move);
+    Color color = color_opposite(board->side_to_move);
+    Color enemy = board->side_to_move;
+
+    if (is_castle(move)) {
+        Square rook_from, rook_to;
+        castle_rook_squares(color, move_flags(move), &rook_from, &rook_to);
+        move_piece(board, color, ROOK, rook_to, rook_from);
+    }
+    if (is_promotion(move)) {
+        remove_piece(board, color, promotion_piece(move), to);
+        put_piece(board, color, PAWN, from);
+    } else {
+        move_piece(board, color, (PieceType)board->piece_on[to], to, from);
+    }
+    if (st->captured != NO_PIECE) {
+        Square captured_sq = to;
+        if (is_en_passant(move))
+            captured_sq = (color == WHITE) ? (Square)(to - 8) : (Square)(to + 8);
+        put_piece(board, enemy, st->captured, captured_sq);
+    }
+    board->empty = ~board->occupied;
+    board->en_passant = st->en_passant;
+    board->castling_rights = st->castling_rights;
+    board->halfmove_clock = st->halfmove_clock;
+    board->key = st->key;
+    if (color == BLACK) board->fullmove_number--;
+    board->side_to_move = color;
+    check_key(board);
+}
+
+// Pass the move to the opponent (used by null-move pruning)
+void board_make_null_move(Board* board) {
+    uint64_t key = board->key ^ zobrist_side;
+    if (board->en_passant != A1) key ^= zobrist_ep[board->en_passant];
+    tt_prefetch(key);
+
+    BoardState* st = &board->history[board->ply++ & (MAX_GAME_PLY - 1)];
+    st->captured = NO_PIECE;
+    st->en_passant = board->en_passant;
+    st->castling_rights = board->castling_rights;
+    st->halfmove_clock = board->halfmove_clock;
+    st->key = board->key;
+
+    board->en_passant = A1;
+    board->key = key;
+    board->halfmove_clock++;
+    board->side_to_move = color_opposite(board->side_to_move);
+    check_key(board);
+}
+
+void board_undo_null_move(Board* board) {
+    const BoardState* st = &board->history[--board->ply & (MAX_GAME_PLY - 1)];
+    board->en_passant = st->en_passant;
+    board->halfmove_clock = st->halfmove_clock;
+    board->key = st->key;
+    board->side_to_move = color_opposite(board->side_to_move);
+    check_key(board);
 }
 
 int board_is_check(const Board* board) {
@@ -245,23 +392,19 @@ int board_is_check(const Board* board) {
 }
 
 int board_is_checkmate(const Board* board) {
-    if (!board_is_check(board)) return 0;
+    AttackInfo ai;
+    attack_info_init(board, &ai);
+    if (!ai.checkers) return 0;
     Move moves[256];
-    int count = generate_moves(board, moves);
-    for (int i = 0; i < count; i++) {
-        if (is_legal_move(board, moves[i])) return 0;
-    }
-    return 1;
+    return generate_by_type(board, &ai, GEN_ALL, moves) == 0;
 }
 
 int board_is_stalemate(const Board* board) {
-    if (board_is_check(board)) return 0;
+    AttackInfo ai;
+    attack_info_init(board, &ai);
+    if (ai.checkers) return 0;
     Move moves[256];
-    int count = generate_moves(board, moves);
-    for (int i = 0; i < count; i++) {
-        if (is_legal_move(board, moves[i])) return 0;
-    }
-    return 1;
+    return generate_by_type(board, &ai, GEN_ALL, moves) == 0;
 }
 
 int board_is_legal_move(const Board* board, Move move) {
@@ -274,26 +417,16 @@ Bitboard board_get_pieces(const Board* board, Color color, PieceType piece) {
 }
 
 Bitboard board_get_all_pieces(const Board* board, Color color) {
-    Bitboard result = 0;
-    for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-        result |= board->pieces[color][pt];
-    return result;
+    return board->by_color[color];
 }
 
 PieceType board_get_piece_at(const Board* board, Square sq) {
-    for (Color c = WHITE; c < COLOR_COUNT; c++)
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-            if (board->pieces[c][pt] & (1ULL << sq))
-                return pt;
-    return PAWN;
+    PieceType piece = (PieceType)board->piece_on[sq];
+    return piece == NO_PIECE ? PAWN : piece;
 }
 
 Color board_get_color_at(const Board* board, Square sq) {
-    for (Color c = WHITE; c < COLOR_COUNT; c++)
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++)
-            if (board->pieces[c][pt] & (1ULL << sq))
-                return c;
-    return WHITE;
+    return (board->by_color[BLACK] & (1ULL << sq)) ? BLACK : WHITE;
 }
 
 int board_is_square_occupied(const Board* board, Square sq) {
@@ -308,48 +441,27 @@ int board_is_square_attacked(const Board* board, Square sq, Color by_color) {
     // King attacks
     if (king_attacks[sq] & board->pieces[by_color][KING]) return 1;
 
-    Bitboard occupied = board->occupied;
-    // Bishop/Queen diagonals
-    int diag_deltas[4] = { 9, 7, -7, -9 };
-    for (int d = 0; d < 4; d++) {
-        int to = (int)sq + diag_deltas[d];
-        while (to >= 0 && to < 64) {
-            int prev = to - diag_deltas[d];
-            int file_diff = (int)file_of((Square)to) - (int)file_of((Square)prev);
-            if (file_diff != 1 && file_diff != -1) break;
-            if (test_bit(occupied, (Square)to)) {
-                if (test_bit(board->pieces[by_color][BISHOP], (Square)to) ||
-                    test_bit(board->pieces[by_color][QUEEN], (Square)to)) {
-                    return 1;
-                }
-                break;
-            }
-            to += diag_deltas[d];
-        }
-    }
-    // Rook/Queen straight lines
-    int ortho_deltas[4] = { 8, -8, 1, -1 };
-    for (int d = 0; d < 4; d++) {
-        int to = (int)sq + ortho_deltas[d];
-        while (to >= 0 && to < 64) {
-            if (d >= 2) {
-                int prev = to - ortho_deltas[d];
-                int file_diff = (int)file_of((Square)to) - (int)file_of((Square)prev);
-                if (file_diff != 1 && file_diff != -1) break;
-            }
-            if (test_bit(occupied, (Square)to)) {
-                if (test_bit(board->pieces[by_color][ROOK], (Square)to) ||
-                    test_bit(board->pieces[by_color][QUEEN], (Square)to)) {
-                    return 1;
-                }
-                break;
-            }
-            to += ortho_deltas[d];
-        }
-    }
+    // Sliders
+    Bitboard queens = board->pieces[by_color][QUEEN];
+    if (bishop_attacks(sq, board->occupied) & (board->pieces[by_color][BISHOP] | queens)) return 1;
+    if (rook_attacks(sq, board->occupied) & (board->pieces[by_color][ROOK] | queens)) return 1;
     return 0;
 }
 
+// All pieces of either color attacking a square, given an occupancy
+Bitboard board_attackers_to(const Board* board, Square sq, Bitboard occupied) {
+    Bitboard bishops = board->pieces[WHITE][BISHOP] | board->pieces[BLACK][BISHOP] |
+                       board->pieces[WHITE][QUEEN] | board->pieces[BLACK][QUEEN];
+    Bitboard rooks = board->pieces[WHITE][ROOK] | board->pieces[BLACK][ROOK] |
+                     board->pieces[WHITE][QUEEN] | board->pieces[BLACK][QUEEN];
+    return (pawn_attacks[BLACK][sq] & board->pieces[WHITE][PAWN]) |
+           (pawn_attacks[WHITE][sq] & board->pieces[BLACK][PAWN]) |
+           (knight_attacks[sq] & (board->pieces[WHITE][KNIGHT] | board->pieces[BLACK][KNIGHT])) |
+           (king_attacks[sq] & (board->pieces[WHITE][KING] | board->pieces[BLACK][KING])) |
+           (bishop_attacks(sq, occupied) & bishops) |
+           (rook_attacks(sq, occupied) & rooks);
+}
+
 void board_print(const Board* board) {
     printf("\n");
     for (Rank r = RANK_8; r >= RANK_1; r--) {
@@ -367,6 +479,7 @@ void board_print(const Board* board) {
                             case ROOK: piece_char = 'r'; break;
                             case QUEEN: piece_char = 'q'; break;
                             case KING: piece_char = 'k'; break;
+                            default: break;
                         }
                         if (c == WHITE) piece_char = toupper(piece_char);
                     }
@@ -384,6 +497,14 @@ int board_validate(const Board* board) {
         for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
             if (board->pieces[c][pt] & all_pieces) return 0;
             all_pieces |= board->pieces[c][pt];
+            Bitboard bb = board->pieces[c][pt];
+            while (bb) {
+                Square sq = pop_lsb(&bb);
+                if (board->piece_on[sq] != pt || !(board->by_color[c] & (1ULL << sq))) return 0;
+            }
         }
+    if (all_pieces != board->occupied || (board->by_color[WHITE] | board->by_color[BLACK]) != all_pieces) return 0;
+    for (Square sq = A1; sq < SQUARE_COUNT; sq++)
+        if (!(all_pieces & (1ULL << sq)) && board->piece_on[sq] != NO_PIECE) return 0;
     return 1;
 }
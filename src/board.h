@@ -5,16 +5,33 @@
 #include "bitboard.h"
 #include "move.h"
 
+// Undo stack depth (indexed modulo, so long games wrap instead of overflowing)
+#define MAX_GAME_PLY 1024
+
+// Irreversible state saved by board_make_move and restored by board_undo_move
+typedef struct {
+    PieceType captured;      // Piece captured by the move (NO_PIECE if none)
+    Square en_passant;       // En passant square before the move
+    int castling_rights;     // Castling rights before the move
+    int halfmove_clock;      // Halfmove clock before the move
+    uint64_t key;            // Zobrist key before the move
+} BoardState;
+
 // Board structure
 typedef struct {
     Bitboard pieces[2][6];  // [color][piece_type]
+    Bitboard by_color[2];    // All pieces of each color
     Bitboard occupied;       // All occupied squares
     Bitboard empty;          // All empty squares
+    uint8_t piece_on[64];    // PieceType on each square (NO_PIECE if empty)
     Color side_to_move;      // Current side to move
     Square en_passant;       // En passant square (if any)
     int castling_rights;     // Castling rights (bit flags)
     int halfmove_clock;      // Halfmove clock for 50-move rule
     int fullmove_number;     // Fullmove number
+    uint64_t key;            // Zobrist key, updated incrementally
+    int ply;                 // Moves made since the last board_init/board_set_fen
+    BoardState history[MAX_GAME_PLY]; // Undo stack
 } Board;
 
 // Castling rights
@@ -27,8 +44,11 @@ typedef struct {
 void board_init(Board* board);
 void board_set_fen(Board* board, const char* fen);
 void board_get_fen(const Board* board, char* fen);
+uint64_t board_key_after(const Board* board, Move move);
 void board_make_move(Board* board, Move move);
 void board_undo_move(Board* board, Move move);
+void board_make_null_move(Board* board);
+void board_undo_null_move(Board* board);
 int board_is_check(const Board* board);
 int board_is_checkmate(const Board* board);
 int board_is_stalemate(const Board* board);
@@ -41,6 +61,7 @@ PieceType board_get_piece_at(const Board* board, Square sq);
 Color board_get_color_at(const Board* board, Square sq);
 int board_is_square_occupied(const Board* board, Square sq);
 int board_is_square_attacked(const Board* board, Square sq, Color by_color);
+Bitboard board_attackers_to(const Board* board, Square sq, Bitboard occupied);
 
 // Utility functions
 void board_print(const Board* board);
@@ -11,7 +11,8 @@ typedef enum {
     ROOK = 3,
     QUEEN = 4,
     KING = 5,
-    PIECE_COUNT = 6
+    PIECE_COUNT = 6,
+    NO_PIECE = PIECE_COUNT
 } PieceType;
 
 // Colors
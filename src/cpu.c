@@ -0,0 +1,23 @@
+#include "cpu.h"
+#include <string.h>
+
+CpuFeatures cpu_features;
+
+void cpu_detect(void) {
+    memset(&cpu_features, 0, sizeof(cpu_features));
+#if !defined(CPU_GENERIC) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    cpu_features.popcnt = __builtin_cpu_supports("popcnt") != 0;
+    cpu_features.bmi2 = __builtin_cpu_supports("bmi2") != 0;
+    cpu_features.avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+
+const char* cpu_feature_string(void) {
+    static char buffer[32];
+    buffer[0] = '\0';
+    if (cpu_features.popcnt) strcat(buffer, " popcnt");
+    if (cpu_features.bmi2) strcat(buffer, " bmi2");
+    if (cpu_features.avx2) strcat(buffer, " avx2");
+    return buffer[0] ? buffer + 1 : "none";
+}
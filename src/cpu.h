@@ -0,0 +1,20 @@
+#ifndef CPU_H
+#define CPU_H
+
+// Instruction set extensions found at startup. Build with -DCPU_GENERIC
+// (make generic) to ignore them and run the portable kernels only.
+typedef struct {
+    int popcnt;
+    int bmi2;
+    int avx2;
+} CpuFeatures;
+
+extern CpuFeatures cpu_features;
+
+// Fill cpu_features; safe to call more than once
+void cpu_detect(void);
+
+// Space-separated list of detected features ("none" if there are none)
+const char* cpu_feature_string(void);
+
+#endif // CPU_H
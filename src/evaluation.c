@@ -1,143 +1,33 @@
 #include "evaluation.h"
 #include "bitboard.h"
+#include "attackinfo.h"
 // movegen.h not required for evaluation here
 
 // Forward declaration
 static int evaluate_positional(const Board* board);
-static int evaluate_mobility(const Board* board);
+static int evaluate_mobility(const Board* board, const AttackInfo* ai);
 static int evaluate_pawn_structure(const Board* board);
-static int evaluate_king_safety(const Board* board);
+static int evaluate_king_safety(const Board* board, const AttackInfo* ai);
 static int evaluate_bishop_pair(const Board* board);
 static int evaluate_rook_position(const Board* board);
 
-// Piece-square tables
-int pawn_table[64];
-int knight_table[64];
-int bishop_table[64];
-int rook_table[64];
-int queen_table[64];
-int king_table[64];
-
-// Mobility tables
-int knight_mobility_bonus[9];
-int bishop_mobility_bonus[14];
-int rook_mobility_bonus[15];
-int queen_mobility_bonus[28];
-
-// Initialize evaluation tables
-void init_evaluation_tables(void) {
-    // Pawn table - encourage center pawns and pawn advancement
-    for (int i = 0; i < 64; i++) {
-        Rank r = rank_of(i);
-        File f = file_of(i);
-        int bonus = 0;
-        
-        // Center bonus
-        if (f >= FILE_C && f <= FILE_F) bonus += 10;
-        
-        // Advancement bonus
-        if (r >= RANK_4 && r <= RANK_6) bonus += 5;
-        if (r >= RANK_5) bonus += 10;
-        
-        pawn_table[i] = bonus;
-    }
-    
-    // Knight table - encourage knights in the center
-    for (int i = 0; i < 64; i++) {
-        Rank r = rank_of(i);
-        File f = file_of(i);
-        int bonus = 0;
-        
-        // Center bonus
-        if (r >= RANK_3 && r <= RANK_6 && f >= FILE_C && f <= FILE_F) bonus += 10;
-        
-        // Edge penalty
-        if (r == RANK_1 || r == RANK_8 || f == FILE_A || f == FILE_H) bonus -= 5;
-        
-        knight_table[i] = bonus;
-    }
-    
-    // Bishop table - encourage bishops on long diagonals
-    for (int i = 0; i < 64; i++) {
-        Rank r = rank_of(i);
-        File f = file_of(i);
-        int bonus = 0;
-        
-        // Center bonus
-        if (r >= RANK_3 && r <= RANK_6 && f >= FILE_C && f <= FILE_F) bonus += 5;
-        
-        bishop_table[i] = bonus;
-    }
-    
-    // Rook table - encourage rooks on open files and 7th rank
-    for (int i = 0; i < 64; i++) {
-        Rank r = rank_of(i);
-        File f = file_of(i);
-        int bonus = 0;
-        
-        // 7th rank bonus
-        if (r == RANK_7) bonus += 20;
-        
-        // Center files bonus
-        if (f >= FILE_C && f <= FILE_F) bonus += 5;
-        
-        rook_table[i] = bonus;
-    }
-    
-    // Queen table - encourage queen in the center
-    for (int i = 0; i < 64; i++) {
-        Rank r = rank_of(i);
-        File f = file_of(i);
-        int bonus = 0;
-        
-        // Center bonus
-        if (r >= RANK_3 && r <= RANK_6 && f >= FILE_C && f <= FILE_F) bonus += 5;
-        
-        queen_table[i] = bonus;
-    }
-    
-    // King table - encourage king safety
-    for (int i = 0; i < 64; i++) {
-        Rank r = rank_of(i);
-        File f = file_of(i);
-        int bonus = 0;
-        
-        // Center penalty (king should stay safe)
-        if (r >= RANK_3 && r <= RANK_6 && f >= FILE_C && f <= FILE_F) bonus -= 10;
-        
-        // Corner bonus (castled position)
-        if ((r == RANK_1 && f == FILE_G) || (r == RANK_1 && f == FILE_C) ||
-            (r == RANK_8 && f == FILE_G) || (r == RANK_8 && f == FILE_C)) bonus += 20;
-        
-        king_table[i] = bonus;
-    }
-    
-    // Initialize mobility tables
-    for (int i = 0; i < 9; i++) {
-        knight_mobility_bonus[i] = i * 3;
-    }
-    
-    for (int i = 0; i < 14; i++) {
-        bishop_mobility_bonus[i] = i * 2;
-    }
-    
-    for (int i = 0; i < 15; i++) {
-        rook_mobility_bonus[i] = i * 2;
-    }
-    
-    for (int i = 0; i < 28; i++) {
-        queen_mobility_bonus[i] = i;
-    }
-}
-
 // Top-level evaluation
 int evaluate_position(const Board* board) {
+    AttackInfo ai;
+    attack_info_init(board, &ai);
+    return evaluate_with_attacks(board, &ai);
+}
+
+// Evaluation reusing attack maps the caller already computed for this position
+int evaluate_with_attacks(const Board* board, AttackInfo* ai) {
+    attack_info_complete(board, ai);
+    
     int score = 0;
     score += evaluate_material(board);
     score += evaluate_positional(board);
-    score += evaluate_mobility(board);
+    score += evaluate_mobility(board, ai);
     score += evaluate_pawn_structure(board);
-    score += evaluate_king_safety(board);
+    score += evaluate_king_safety(board, ai);
     score += evaluate_bishop_pair(board);
     score += evaluate_rook_position(board);
     return score;
@@ -224,33 +114,28 @@ static int evaluate_positional(const Board* board) {
     return score;
 }
 
-// Evaluate piece mobility
-static int evaluate_mobility(const Board* board) {
+// Evaluate piece mobility (squares each piece attacks that are not own pieces)
+static int evaluate_mobility(const Board* board, const AttackInfo* ai) {
     int score = 0;
     
     for (Color c = WHITE; c < COLOR_COUNT; c++) {
         int color_multiplier = (c == WHITE) ? 1 : -1;
+        Bitboard own = board->by_color[c];
         
         // Count knight moves
         Bitboard knights = board->pieces[c][KNIGHT];
         while (knights) {
             Square sq = pop_lsb(&knights);
-            Bitboard attacks = knight_attacks[sq] & ~board->pieces[c][0] & ~board->pieces[c][1] & ~board->pieces[c][2] & ~board->pieces[c][3] & ~board->pieces[c][4] & ~board->pieces[c][5];
-            int mobility = pop_count(attacks);
-            if (mobility < 9) {
-                score += color_multiplier * knight_mobility_bonus[mobility];
-            }
+            int mobility = pop_count(ai->piece_attacks[sq] & ~own);
+            score += color_multiplier * knight_mobility_bonus[mobility];
         }
         
-        // Count bishop moves (simplified)
+        // Count bishop moves
         Bitboard bishops = board->pieces[c][BISHOP];
         while (bishops) {
             Square sq = pop_lsb(&bishops);
-            // Simplified bishop mobility calculation
-            int mobility = 8; // Approximate
-            if (mobility < 14) {
-                score += color_multiplier * bishop_mobility_bonus[mobility];
-            }
+            int mobility = pop_count(ai->piece_attacks[sq] & ~own);
+            score += color_multiplier * bishop_mobility_bonus[mobility];
         }
     }
     
@@ -293,7 +178,7 @@ static int evaluate_pawn_structure(const Board* board) {
 }
 
 // Evaluate king safety
-static int evaluate_king_safety(const Board* board) {
+static int evaluate_king_safety(const Board* board, const AttackInfo* ai) {
     int score = 0;
     
     for (Color c = WHITE; c < COLOR_COUNT; c++) {
@@ -315,6 +200,9 @@ static int evaluate_king_safety(const Board* board) {
                 (r == RANK_8 && (f == FILE_G || f == FILE_C))) {
                 score += color_multiplier * 30;
             }
+            
+            // Penalty for each square next to the king the enemy attacks
+            score -= color_multiplier * pop_count(king_attacks[king_sq] & ai->by_color[color_opposite(c)]);
         }
     }
     
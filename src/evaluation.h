@@ -3,6 +3,7 @@
 
 #include "constants.h"
 #include "board.h"
+#include "attackinfo.h"
 
 // Piece values
 #define PAWN_VALUE   100
@@ -22,25 +23,23 @@
 
 // Main evaluation function
 int evaluate_position(const Board* board);
+int evaluate_with_attacks(const Board* board, AttackInfo* ai);
 
 // Evaluation components
 int evaluate_material(const Board* board);
 
-// Initialize evaluation tables
-void init_evaluation_tables(void);
-
-// Piece-square tables
-extern int pawn_table[64];
-extern int knight_table[64];
-extern int bishop_table[64];
-extern int rook_table[64];
-extern int queen_table[64];
-extern int king_table[64];
+// Piece-square tables (generated at build time by tools/gentables.c)
+extern const int pawn_table[64];
+extern const int knight_table[64];
+extern const int bishop_table[64];
+extern const int rook_table[64];
+extern const int queen_table[64];
+extern const int king_table[64];
 
 // Mobility tables
-extern int knight_mobility_bonus[9];
-extern int bishop_mobility_bonus[14];
-extern int rook_mobility_bonus[15];
-extern int queen_mobility_bonus[28];
+extern const int knight_mobility_bonus[9];
+extern const int bishop_mobility_bonus[14];
+extern const int rook_mobility_bonus[15];
+extern const int queen_mobility_bonus[28];
 
 #endif // EVALUATION_H 
\ No newline at end of file
@@ -1,120 +1,172 @@
 #include "movegen.h"
 #include "bitboard.h"
-#include <stdlib.h>
 
-// Helper function to check if a square is on the board and reachable
-static inline int is_valid_destination(Square from, Square to, int delta) {
-    if (to < 0 || to >= 64) return 0;
-    
-    // For diagonal and horizontal moves, check file distance
-    if (delta == 9 || delta == 7 || delta == -7 || delta == -9) {
-        // Diagonal moves: file and rank differences must be equal
-        int file_diff = abs((int)file_of(to) - (int)file_of(from));
-        int rank_diff = abs((int)rank_of(to) - (int)rank_of(from));
-        return file_diff == rank_diff;
-    } else if (delta == 1 || delta == -1) {
-        // Horizontal moves: must stay on same rank
-        return rank_of(to) == rank_of(from);
-    }
-    return 1; // Vertical moves (delta ±8) are always valid if within bounds
+// Castling geometry: right, king and rook squares, squares that must be
+// empty, and squares the king crosses that must not be attacked
+typedef struct {
+    int right;
+    uint8_t flag;
+    Square king_from;
+    Square king_to;
+    Square rook_from;
+    Bitboard path;
+    Square crossed[2];
+} CastleInfo;
+
+static const CastleInfo castle_info[2][2] = {
+    { { WHITE_KINGSIDE,  KING_CASTLE,  E1, G1, H1, (1ULL << F1) | (1ULL << G1), { F1, G1 } },
+      { WHITE_QUEENSIDE, QUEEN_CASTLE, E1, C1, A1, (1ULL << B1) | (1ULL << C1) | (1ULL << D1), { D1, C1 } } },
+    { { BLACK_KINGSIDE,  KING_CASTLE,  E8, G8, H8, (1ULL << F8) | (1ULL << G8), { F8, G8 } },
+      { BLACK_QUEENSIDE, QUEEN_CASTLE, E8, C8, A8, (1ULL << B8) | (1ULL << C8) | (1ULL << D8), { D8, C8 } } }
+};
+
+// Castling conditions other than "not currently in check"
+static int can_castle(const Board* board, const AttackInfo* ai, const CastleInfo* ci) {
+    Color color = board->side_to_move;
+    return (board->castling_rights & ci->right) &&
+           !(board->occupied & ci->path) &&
+           test_bit(board->pieces[color][ROOK], ci->rook_from) &&
+           !test_bit(ai->by_color[color_opposite(color)], ci->crossed[0]) &&
+           !test_bit(ai->by_color[color_opposite(color)], ci->crossed[1]);
 }
 
-// Generate all legal moves for the current position (not pseudo-legal)
-int generate_moves(const Board* board, Move* moves) {
+// Generate the legal moves of one kind; in check, non-king moves must capture or block
+int generate_by_type(const Board* board, const AttackInfo* info, GenType type, Move* moves) {
     int count = 0;
-    Move pseudo_moves[256];
-    int pseudo_count = 0;
-    
-    // Generate all pseudo-legal moves
-    generate_pawn_moves(board, pseudo_moves, &pseudo_count);
-    generate_knight_moves(board, pseudo_moves, &pseudo_count);
-    generate_bishop_moves(board, pseudo_moves, &pseudo_count);
-    generate_rook_moves(board, pseudo_moves, &pseudo_count);
-    generate_queen_moves(board, pseudo_moves, &pseudo_count);
-    generate_king_moves(board, pseudo_moves, &pseudo_count);
-    
-    // Filter out illegal moves (moves that leave king in check)
-    for (int i = 0; i < pseudo_count; i++) {
-        if (is_legal_move(board, pseudo_moves[i])) {
-            moves[count++] = pseudo_moves[i];
-        }
+
+    // Double check: only the king can move
+    if (info->checkers & (info->checkers - 1)) {
+        generate_king_moves(board, info, type, moves, &count);
+        return count;
+    }
+
+    Bitboard target;
+    switch (type) {
+        case GEN_CAPTURES: target = board_get_all_pieces(board, color_opposite(board->side_to_move)); break;
+        case GEN_QUIETS:   target = board->empty; break;
+        default:           target = ~board_get_all_pieces(board, board->side_to_move); break;
+    }
+    if (info->checkers) {
+        target &= info->checkers | between_bb[info->king_sq][lsb(info->checkers)];
     }
+
+    generate_pawn_moves(board, info, type, target, moves, &count);
+    generate_knight_moves(board, info, target, moves, &count);
+    generate_bishop_moves(board, info, target, moves, &count);
+    generate_rook_moves(board, info, target, moves, &count);
+    generate_queen_moves(board, info, target, moves, &count);
+    generate_king_moves(board, info, type, moves, &count);
     
     return count;
 }
 
+// Generate all legal moves for the current position (not pseudo-legal)
+int generate_moves(const Board* board, Move* moves) {
+    AttackInfo info;
+    attack_info_init(board, &info);
+    return generate_by_type(board, &info, GEN_ALL, moves);
+}
+
 // Generate all legal moves - alias for generate_moves for consistency
 int generate_legal_moves(const Board* board, Move* moves) {
     return generate_moves(board, moves);
 }
 
-// Generate pawn moves
-int generate_pawn_moves(const Board* board, Move* moves, int* count) {
+// Generate legal captures and promotions (not for use in check)
+int generate_captures(const Board* board, Move* moves) {
+    AttackInfo info;
+    attack_info_init(board, &info);
+    return generate_by_type(board, &info, GEN_CAPTURES, moves);
+}
+
+// Generate legal non-capturing, non-promoting moves including castling (not for use in check)
+int generate_quiets(const Board* board, Move* moves) {
+    AttackInfo info;
+    attack_info_init(board, &info);
+    return generate_by_type(board, &info, GEN_QUIETS, moves);
+}
+
+// Generate all legal replies to a check
+int generate_evasions(const Board* board, Move* moves) {
+    AttackInfo info;
+    attack_info_init(board, &info);
+    return generate_by_type(board, &info, GEN_ALL, moves);
+}
+
+// Squares a piece on 'from' may move to without exposing its own king
+static inline Bitboard pin_mask(const AttackInfo* info, Square from) {
+    return (info->pinned & (1ULL << from)) ? line_bb[info->king_sq][from] : ~0ULL;
+}
+
+// Add the four promotion choices (knight, bishop, rook, queen)
+static inline void add_promotions(Square from, Square to, uint8_t base_flag, Move* moves, int* count) {
+    for (int promo = 0; promo < 4; promo++) {
+        moves[*count] = make_move(from, to, (uint8_t)(base_flag | promo));
+        (*count)++;
+    }
+}
+
+// Generate pawn moves landing on target squares. Promotions and en passant
+// belong to GEN_CAPTURES, other pushes to GEN_QUIETS.
+int generate_pawn_moves(const Board* board, const AttackInfo* info, GenType type, Bitboard target, Move* moves, int* count) {
     Color color = board->side_to_move;
     Bitboard pawns = board->pieces[color][PAWN];
     Bitboard empty = board->empty;
     Bitboard enemies = board_get_all_pieces(board, color_opposite(color));
+    Rank promotion_rank = (color == WHITE) ? RANK_8 : RANK_1;
+    Rank start_rank = (color == WHITE) ? RANK_2 : RANK_7;
+    
+    // Promotion pushes land on empty squares but count as captures here
+    if (type == GEN_CAPTURES) {
+        target |= empty & rank_bb[promotion_rank];
+        if (info->checkers) target &= between_bb[info->king_sq][lsb(info->checkers)] | enemies;
+    }
     
     while (pawns) {
         Square from = pop_lsb(&pawns);
+        Bitboard allowed = target & pin_mask(info, from);
         
         // Single pawn push
         Square push_sq = (color == WHITE) ? (Square)(from + 8) : (Square)(from - 8);
-        if (push_sq >= 0 && push_sq < 64 && test_bit(empty, push_sq)) {
-            // Check for promotion
-            if ((color == WHITE && rank_of(push_sq) == RANK_8) || 
-                (color == BLACK && rank_of(push_sq) == RANK_1)) {
-                // Generate all 4 promotion pieces
-                moves[*count] = make_move(from, push_sq, (uint8_t)(PROMOTION | 0)); // Knight
-                (*count)++;
-                moves[*count] = make_move(from, push_sq, (uint8_t)(PROMOTION | 1)); // Bishop
-                (*count)++;
-                moves[*count] = make_move(from, push_sq, (uint8_t)(PROMOTION | 2)); // Rook
-                (*count)++;
-                moves[*count] = make_move(from, push_sq, (uint8_t)(PROMOTION | 3)); // Queen
-                (*count)++;
-            } else {
-                moves[*count] = make_move(from, push_sq, QUIET);
-                (*count)++;
-                
-                // Double pawn push from starting rank
-                if ((color == WHITE && rank_of(from) == RANK_2) || 
-                    (color == BLACK && rank_of(from) == RANK_7)) {
-                    Square double_push = (color == WHITE) ? (Square)(from + 16) : (Square)(from - 16);
-                    if (double_push >= 0 && double_push < 64 && test_bit(empty, double_push)) {
-                        moves[*count] = make_move(from, double_push, DOUBLE_PAWN_PUSH);
-                        (*count)++;
-                    }
+        if (test_bit(empty, push_sq)) {
+            if (test_bit(allowed, push_sq)) {
+                if (rank_of(push_sq) == promotion_rank) {
+                    if (type != GEN_QUIETS) add_promotions(from, push_sq, PROMOTION, moves, count);
+                } else if (type != GEN_CAPTURES) {
+                    moves[*count] = make_move(from, push_sq, QUIET);
+                    (*count)++;
+                }
+            }
+            
+            // Double pawn push from starting rank
+            if (rank_of(from) == start_rank && type != GEN_CAPTURES) {
+                Square double_push = (color == WHITE) ? (Square)(from + 16) : (Square)(from - 16);
+                if (test_bit(empty & allowed, double_push)) {
+                    moves[*count] = make_move(from, double_push, DOUBLE_PAWN_PUSH);
+                    (*count)++;
                 }
             }
         }
         
+        if (type == GEN_QUIETS) continue;
+        
         // Pawn captures
-        Bitboard attacks = pawn_attacks[color][from] & enemies;
+        Bitboard attacks = pawn_attacks[color][from] & enemies & allowed;
         while (attacks) {
             Square to = pop_lsb(&attacks);
-            if ((color == WHITE && rank_of(to) == RANK_8) || 
-                (color == BLACK && rank_of(to) == RANK_1)) {
-                // Capture promotions
-                moves[*count] = make_move(from, to, (uint8_t)(PROMOTION_CAPTURE | 0)); // Knight
-                (*count)++;
-                moves[*count] = make_move(from, to, (uint8_t)(PROMOTION_CAPTURE | 1)); // Bishop
-                (*count)++;
-                moves[*count] = make_move(from, to, (uint8_t)(PROMOTION_CAPTURE | 2)); // Rook
-                (*count)++;
-                moves[*count] = make_move(from, to, (uint8_t)(PROMOTION_CAPTURE | 3)); // Queen
-                (*count)++;
+            if (rank_of(to) == promotion_rank) {
+                add_promotions(from, to, PROMOTION_CAPTURE, moves, count);
             } else {
                 moves[*count] = make_move(from, to, CAPTURE);
                 (*count)++;
             }
         }
         
-        // En passant
-        if (board->en_passant != A1) {
-            Bitboard ep_attacks = pawn_attacks[color][from] & square_bb[board->en_passant];
-            if (ep_attacks) {
-                moves[*count] = make_move(from, board->en_passant, EN_PASSANT);
+        // En passant can uncover the king along the rank, so test it fully
+        if (board->en_passant != A1 && (pawn_attacks[color][from] & square_bb[board->en_passant])) {
+            Move ep = make_move(from, board->en_passant, EN_PASSANT);
+            if (is_legal_move(board, ep)) {
+                moves[*count] = ep;
                 (*count)++;
             }
         }
@@ -123,20 +175,19 @@ int generate_pawn_moves(const Board* board, Move* moves, int* count) {
     return *count;
 }
 
-// Generate knight moves
-int generate_knight_moves(const Board* board, Move* moves, int* count) {
+// Generate knight moves landing on target squares (a pinned knight never moves)
+int generate_knight_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count) {
     Color color = board->side_to_move;
-    Bitboard knights = board->pieces[color][KNIGHT];
-    Bitboard own_pieces = board_get_all_pieces(board, color);
+    Bitboard knights = board->pieces[color][KNIGHT] & ~info->pinned;
+    Bitboard enemy_pieces = board_get_all_pieces(board, color_opposite(color));
     
     while (knights) {
         Square from = pop_lsb(&knights);
-        Bitboard attacks = knight_attacks[from] & ~own_pieces;
+        Bitboard attacks = knight_attacks[from] & target;
         
         while (attacks) {
             Square to = pop_lsb(&attacks);
-            Bitboard enemies = board_get_all_pieces(board, color_opposite(color));
-            uint8_t flags = test_bit(enemies, to) ? CAPTURE : QUIET;
+            uint8_t flags = test_bit(enemy_pieces, to) ? CAPTURE : QUIET;
             moves[*count] = make_move(from, to, flags);
             (*count)++;
         }
@@ -145,160 +196,95 @@ int generate_knight_moves(const Board* board, Move* moves, int* count) {
     return *count;
 }
 
-// Generate bishop moves (sliding along diagonals)
-int generate_bishop_moves(const Board* board, Move* moves, int* count) {
+// Generate bishop moves (sliding along diagonals) landing on target squares
+int generate_bishop_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count) {
     Color color = board->side_to_move;
     Bitboard bishops = board->pieces[color][BISHOP];
-    Bitboard own_pieces = board_get_all_pieces(board, color);
     Bitboard enemy_pieces = board_get_all_pieces(board, color_opposite(color));
     
     while (bishops) {
         Square from = pop_lsb(&bishops);
-        int deltas[4] = { 9, 7, -7, -9 }; // NE, NW, SW, SE
+        Bitboard attacks = bishop_attacks(from, board->occupied) & target & pin_mask(info, from);
         
-        for (int d = 0; d < 4; d++) {
-            int to = (int)from + deltas[d];
-            
-            while (to >= 0 && to < 64 && is_valid_destination(from, (Square)to, deltas[d])) {
-                if (test_bit(own_pieces, (Square)to)) break; // Blocked by own piece
-                
-                uint8_t flags = test_bit(enemy_pieces, (Square)to) ? CAPTURE : QUIET;
-                moves[*count] = make_move(from, (Square)to, flags);
-                (*count)++;
-                
-                if (flags == CAPTURE) break; // Can't continue past capture
-                to += deltas[d];
-            }
+        while (attacks) {
+            Square to = pop_lsb(&attacks);
+            uint8_t flags = test_bit(enemy_pieces, to) ? CAPTURE : QUIET;
+            moves[*count] = make_move(from, to, flags);
+            (*count)++;
         }
     }
     
     return *count;
 }
 
-// Generate rook moves (sliding along ranks/files)
-int generate_rook_moves(const Board* board, Move* moves, int* count) {
+// Generate rook moves (sliding along ranks/files) landing on target squares
+int generate_rook_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count) {
     Color color = board->side_to_move;
     Bitboard rooks = board->pieces[color][ROOK];
-    Bitboard own_pieces = board_get_all_pieces(board, color);
     Bitboard enemy_pieces = board_get_all_pieces(board, color_opposite(color));
     
     while (rooks) {
         Square from = pop_lsb(&rooks);
-        int deltas[4] = { 8, -8, 1, -1 }; // N, S, E, W
+        Bitboard attacks = rook_attacks(from, board->occupied) & target & pin_mask(info, from);
         
-        for (int d = 0; d < 4; d++) {
-            int to = (int)from + deltas[d];
-            
-            while (to >= 0 && to < 64 && is_valid_destination(from, (Square)to, deltas[d])) {
-                if (test_bit(own_pieces, (Square)to)) break; // Blocked by own piece
-                
-                uint8_t flags = test_bit(enemy_pieces, (Square)to) ? CAPTURE : QUIET;
-                moves[*count] = make_move(from, (Square)to, flags);
-                (*count)++;
-                
-                if (flags == CAPTURE) break; // Can't continue past capture
-                to += deltas[d];
-            }
+        while (attacks) {
+            Square to = pop_lsb(&attacks);
+            uint8_t flags = test_bit(enemy_pieces, to) ? CAPTURE : QUIET;
+            moves[*count] = make_move(from, to, flags);
+            (*count)++;
         }
     }
     
     return *count;
 }
 
-// Generate queen moves (sliding: rook + bishop)
-int generate_queen_moves(const Board* board, Move* moves, int* count) {
+// Generate queen moves (sliding: rook + bishop) landing on target squares
+int generate_queen_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count) {
     Color color = board->side_to_move;
     Bitboard queens = board->pieces[color][QUEEN];
-    Bitboard own_pieces = board_get_all_pieces(board, color);
     Bitboard enemy_pieces = board_get_all_pieces(board, color_opposite(color));
     
     while (queens) {
         Square from = pop_lsb(&queens);
-        int deltas[8] = { 9, 7, -7, -9, 8, -8, 1, -1 }; // All 8 directions
+        Bitboard attacks = (bishop_attacks(from, board->occupied) | rook_attacks(from, board->occupied)) & target & pin_mask(info, from);
         
-        for (int d = 0; d < 8; d++) {
-            int to = (int)from + deltas[d];
-            
-            while (to >= 0 && to < 64 && is_valid_destination(from, (Square)to, deltas[d])) {
-                if (test_bit(own_pieces, (Square)to)) break; // Blocked by own piece
-                
-                uint8_t flags = test_bit(enemy_pieces, (Square)to) ? CAPTURE : QUIET;
-                moves[*count] = make_move(from, (Square)to, flags);
-                (*count)++;
-                
-                if (flags == CAPTURE) break; // Can't continue past capture
-                to += deltas[d];
-            }
+        while (attacks) {
+            Square to = pop_lsb(&attacks);
+            uint8_t flags = test_bit(enemy_pieces, to) ? CAPTURE : QUIET;
+            moves[*count] = make_move(from, to, flags);
+            (*count)++;
         }
     }
     
     return *count;
 }
 
-// Generate king moves
-int generate_king_moves(const Board* board, Move* moves, int* count) {
+// Generate king moves to squares the enemy does not attack
+int generate_king_moves(const Board* board, const AttackInfo* info, GenType type, Move* moves, int* count) {
     Color color = board->side_to_move;
-    Bitboard kings = board->pieces[color][KING];
-    Bitboard own_pieces = board_get_all_pieces(board, color);
+    Color enemy = color_opposite(color);
+    Square from = info->king_sq;
+    Bitboard enemy_pieces = board_get_all_pieces(board, enemy);
+    Bitboard attacks = king_attacks[from] & ~board_get_all_pieces(board, color) &
+                       ~attack_info_king_danger(board, info);
     
-    while (kings) {
-        Square from = pop_lsb(&kings);
-        Bitboard attacks = king_attacks[from] & ~own_pieces;
-        
-        while (attacks) {
-            Square to = pop_lsb(&attacks);
-            Bitboard enemy_pieces = board_get_all_pieces(board, color_opposite(color));
-            uint8_t flags = test_bit(enemy_pieces, to) ? CAPTURE : QUIET;
-            moves[*count] = make_move(from, to, flags);
-            (*count)++;
-        }
-        
-        // Castling moves - only generate if all conditions are met
-        if (!board_is_check(board)) { // Can't castle out of check
-            if (color == WHITE) {
-                // White kingside castling
-                if ((board->castling_rights & WHITE_KINGSIDE) && 
-                    test_bit(board->empty, F1) && test_bit(board->empty, G1) &&
-                    test_bit(board->pieces[WHITE][ROOK], H1) &&
-                    !board_is_square_attacked(board, E1, BLACK) &&
-                    !board_is_square_attacked(board, F1, BLACK) &&
-                    !board_is_square_attacked(board, G1, BLACK)) {
-                    moves[*count] = make_move(E1, G1, KING_CASTLE);
-                    (*count)++;
-                }
-                
-                // White queenside castling
-                if ((board->castling_rights & WHITE_QUEENSIDE) && 
-                    test_bit(board->empty, B1) && test_bit(board->empty, C1) && test_bit(board->empty, D1) &&
-                    test_bit(board->pieces[WHITE][ROOK], A1) &&
-                    !board_is_square_attacked(board, E1, BLACK) &&
-                    !board_is_square_attacked(board, D1, BLACK) &&
-                    !board_is_square_attacked(board, C1, BLACK)) {
-                    moves[*count] = make_move(E1, C1, QUEEN_CASTLE);
-                    (*count)++;
-                }
-            } else {
-                // Black kingside castling
-                if ((board->castling_rights & BLACK_KINGSIDE) && 
-                    test_bit(board->empty, F8) && test_bit(board->empty, G8) &&
-                    test_bit(board->pieces[BLACK][ROOK], H8) &&
-                    !board_is_square_attacked(board, E8, WHITE) &&
-                    !board_is_square_attacked(board, F8, WHITE) &&
-                    !board_is_square_attacked(board, G8, WHITE)) {
-                    moves[*count] = make_move(E8, G8, KING_CASTLE);
-                    (*count)++;
-                }
-                
-                // Black queenside castling
-                if ((board->castling_rights & BLACK_QUEENSIDE) && 
-                    test_bit(board->empty, B8) && test_bit(board->empty, C8) && test_bit(board->empty, D8) &&
-                    test_bit(board->pieces[BLACK][ROOK], A8) &&
-                    !board_is_square_attacked(board, E8, WHITE) &&
-                    !board_is_square_attacked(board, D8, WHITE) &&
-                    !board_is_square_attacked(board, C8, WHITE)) {
-                    moves[*count] = make_move(E8, C8, QUEEN_CASTLE);
-                    (*count)++;
-                }
+    if (type == GEN_CAPTURES) attacks &= enemy_pieces;
+    else if (type == GEN_QUIETS) attacks &= ~enemy_pieces;
+    
+    while (attacks) {
+        Square to = pop_lsb(&attacks);
+        uint8_t flags = test_bit(enemy_pieces, to) ? CAPTURE : QUIET;
+        moves[*count] = make_move(from, to, flags);
+        (*count)++;
+    }
+    
+    // Castling moves - only generate if all conditions are met
+    if (type != GEN_CAPTURES && !info->checkers) { // Can't castle out of check
+        for (int side = 0; side < 2; side++) {
+            const CastleInfo* ci = &castle_info[color][side];
+            if (can_castle(board, info, ci)) {
+                moves[*count] = make_move(ci->king_from, ci->king_to, ci->flag);
+                (*count)++;
             }
         }
     }
@@ -306,16 +292,79 @@ int generate_king_moves(const Board* board, Move* moves, int* count) {
     return *count;
 }
 
-// Check if a move is legal (does not leave own king in check)
-int is_legal_move(const Board* board, Move move) {
-    Board temp = *board;
-    Color moving_color = board->side_to_move;
+// Check that a move (e.g. from the hash table or a killer slot) could be
+// generated in this position, ignoring only whether it leaves the king in check
+int is_pseudo_legal(const Board* board, const AttackInfo* info, Move move) {
+    Color us = board->side_to_move;
+    Color them = color_opposite(us);
+    Square from = move_from(move);
+    Square to = move_to(move);
+    uint8_t flags = move_flags(move);
     
-    board_make_move(&temp, move);
+    if (move_equal(move, NULL_MOVE) || from == to) return 0;
+    if (!test_bit(board->by_color[us], from) || test_bit(board->by_color[us], to)) return 0;
+    PieceType piece = (PieceType)board->piece_on[from];
     
-    // Find the king square after the move
-    Square king_sq = lsb(temp.pieces[moving_color][KING]);
+    if (is_castle(move)) {
+        if (piece != KING || info->checkers) return 0;
+        const CastleInfo* ci = &castle_info[us][flags == KING_CASTLE ? 0 : 1];
+        return from == ci->king_from && to == ci->king_to && can_castle(board, info, ci);
+    }
+    if (is_en_passant(move)) {
+        return piece == PAWN && board->en_passant != A1 && to == board->en_passant &&
+               (pawn_attacks[us][from] & square_bb[to]);
+    }
+    if (!is_promotion(move) && flags != QUIET && flags != DOUBLE_PAWN_PUSH && flags != CAPTURE) return 0;
+    if (is_capture(move) != test_bit(board->by_color[them], to)) return 0;
     
-    // Check if the king is in check after the move
-    return !board_is_square_attacked(&temp, king_sq, color_opposite(moving_color));
-}
\ No newline at end of file
+    if (piece == PAWN) {
+        Rank promotion_rank = (us == WHITE) ? RANK_8 : RANK_1;
+        Square push_sq = (us == WHITE) ? (Square)(from + 8) : (Square)(from - 8);
+        if (is_promotion(move) != (rank_of(to) == promotion_rank)) return 0;
+        if (is_capture(move)) return (pawn_attacks[us][from] & square_bb[to]) != 0;
+        if (flags == DOUBLE_PAWN_PUSH) {
+            Rank start_rank = (us == WHITE) ? RANK_2 : RANK_7;
+            Square double_push = (us == WHITE) ? (Square)(from + 16) : (Square)(from - 16);
+            return rank_of(from) == start_rank && to == double_push &&
+                   test_bit(board->empty, push_sq) && test_bit(board->empty, to);
+        }
+        return to == push_sq && test_bit(board->empty, to);
+    }
+    if (is_promotion(move) || flags == DOUBLE_PAWN_PUSH) return 0;
+    
+    switch (piece) {
+        case KNIGHT: return test_bit(knight_attacks[from], to);
+        case BISHOP: return test_bit(bishop_attacks(from, board->occupied), to);
+        case ROOK:   return test_bit(rook_attacks(from, board->occupied), to);
+        case QUEEN:  return test_bit(bishop_attacks(from, board->occupied) | rook_attacks(from, board->occupied), to);
+        case KING:   return test_bit(king_attacks[from], to);
+        default:     return 0;
+    }
+}
+
+// Check if a move is legal (does not leave own king in check).
+// Works on the post-move occupancy directly instead of copying the board.
+int is_legal_move(const Board* board, Move move) {
+    Color us = board->side_to_move;
+    Color them = color_opposite(us);
+    Square from = move_from(move);
+    Square to = move_to(move);
+
+    // Occupancy after the move, and enemy pieces removed by it
+    Bitboard occupied = (board->occupied & ~(1ULL << from)) | (1ULL << to);
+    Bitboard removed = 1ULL << to;
+    if (is_en_passant(move)) {
+        Square captured_sq = (us == WHITE) ? (Square)(to - 8) : (Square)(to + 8);
+        occupied &= ~(1ULL << captured_sq);
+        removed |= 1ULL << captured_sq;
+    }
+
+    Square king_sq = (board->piece_on[from] == KING) ? to : lsb(board->pieces[us][KING]);
+    Bitboard queens = board->pieces[them][QUEEN];
+    if (pawn_attacks[us][king_sq] & board->pieces[them][PAWN] & ~removed) return 0;
+    if (knight_attacks[king_sq] & board->pieces[them][KNIGHT] & ~removed) return 0;
+    if (king_attacks[king_sq] & board->pieces[them][KING]) return 0;
+    if (bishop_attacks(king_sq, occupied) & (board->pieces[them][BISHOP] | queens) & ~removed) return 0;
+    if (rook_attacks(king_sq, occupied) & (board->pieces[them][ROOK] | queens) & ~removed) return 0;
+    return 1;
+}
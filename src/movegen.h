@@ -4,18 +4,32 @@
 #include "constants.h"
 #include "board.h"
 #include "move.h"
+#include "attackinfo.h"
 
-// Move generation functions
+// Which moves a generator produces
+typedef enum {
+    GEN_CAPTURES,   // Captures (including en passant) and promotions
+    GEN_QUIETS,     // Everything else, including castling
+    GEN_ALL
+} GenType;
+
+// Move generation functions (all return legal moves only). The variants
+// without an AttackInfo compute one themselves.
+int generate_by_type(const Board* board, const AttackInfo* info, GenType type, Move* moves);
 int generate_moves(const Board* board, Move* moves);
 int generate_legal_moves(const Board* board, Move* moves);
-int generate_pawn_moves(const Board* board, Move* moves, int* count);
-int generate_knight_moves(const Board* board, Move* moves, int* count);
-int generate_bishop_moves(const Board* board, Move* moves, int* count);
-int generate_rook_moves(const Board* board, Move* moves, int* count);
-int generate_queen_moves(const Board* board, Move* moves, int* count);
-int generate_king_moves(const Board* board, Move* moves, int* count);
+int generate_captures(const Board* board, Move* moves);
+int generate_quiets(const Board* board, Move* moves);
+int generate_evasions(const Board* board, Move* moves);
+int generate_pawn_moves(const Board* board, const AttackInfo* info, GenType type, Bitboard target, Move* moves, int* count);
+int generate_knight_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count);
+int generate_bishop_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count);
+int generate_rook_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count);
+int generate_queen_moves(const Board* board, const AttackInfo* info, Bitboard target, Move* moves, int* count);
+int generate_king_moves(const Board* board, const AttackInfo* info, GenType type, Move* moves, int* count);
 
 // Move validation
 int is_legal_move(const Board* board, Move move);
+int is_pseudo_legal(const Board* board, const AttackInfo* info, Move move);
 
 #endif // MOVEGEN_H 
\ No newline at end of file
@@ -0,0 +1,179 @@
+#include "movepick.h"
+#include "movegen.h"
+#include "see.h"
+#include <string.h>
+
+// Hash and killer moves come from other positions and must be re-validated
+static int is_usable(const MovePicker* mp, Move move) {
+    return move_not_equal(move, NULL_MOVE) && is_pseudo_legal(mp->board, mp->ai, move) &&
+           is_legal_move(mp->board, move);
+}
+
+// Above any quiet move's static score plus its histories
+#define EVASION_CAPTURE_BONUS (1 << 20)
+
+static int is_tactical(Move move) {
+    return is_capture(move) || is_promotion(move);
+}
+
+// Butterfly and continuation history of a quiet move
+static int quiet_history(const MovePicker* mp, Move move) {
+    const Board* board = mp->board;
+    Square from = move_from(move);
+    Square to = move_to(move);
+    int piece = board->piece_on[from];
+    int score = (*mp->quiet.history)[board->side_to_move][from][to];
+    for (int i = 0; i < CONTINUATION_PLIES; i++) {
+        if (mp->quiet.continuation[i]) score += (*mp->quiet.continuation[i])[piece][to];
+    }
+    return score;
+}
+
+// Generate one stage into the picker and score every move once. Captures
+// are ordered by MVV-LVA alone, quiets by their history on top of the
+// static heuristics; evasions that capture go before those that do not.
+static void generate_stage(MovePicker* mp, GenType type) {
+    const Board* board = mp->board;
+    Move list[MAX_MOVES];
+    mp->count = generate_by_type(board, mp->ai, type, list);
+    mp->index = 0;
+    for (int i = 0; i < mp->count; i++) {
+        int score = get_move_score(board, list[i]);
+        if (!is_tactical(list[i])) {
+            score += quiet_history(mp, list[i]);
+        } else if (type == GEN_ALL) {
+            score += EVASION_CAPTURE_BONUS;
+        }
+        mp->moves[i].move = list[i];
+        mp->moves[i].score = score;
+    }
+}
+
+// Swap the best-scored remaining move to the front and return it
+static Move select_best(MovePicker* mp) {
+    int best = mp->index;
+    for (int i = best + 1; i < mp->count; i++) {
+        if (mp->moves[i].score > mp->moves[best].score) best = i;
+    }
+    ScoredMove tmp = mp->moves[best];
+    mp->moves[best] = mp->moves[mp->index];
+    mp->moves[mp->index] = tmp;
+    return mp->moves[mp->index++].move;
+}
+
+// Moves already returned by an earlier stage
+static int already_tried(const MovePicker* mp, Move move) {
+    if (move_equal(move, mp->tt_move)) return 1;
+    if (mp->stage == STAGE_QUIETS) {
+        for (int i = 0; i < 3; i++) {
+            if (move_equal(move, mp->refutations[i])) return 1;
+        }
+    }
+    return 0;
+}
+
+// Picker for the main search: TT move, good captures, killers, countermove,
+// quiets, bad captures (or evasions in check)
+void movepick_init(MovePicker* mp, const Board* board, const AttackInfo* ai, Move tt_move,
+                   const QuietOrdering* quiet) {
+    mp->board = board;
+    mp->ai = ai;
+    mp->quiet = *quiet;
+    mp->tt_move = is_usable(mp, tt_move) ? tt_move : NULL_MOVE;
+    mp->refutations[0] = quiet->killers[0];
+    mp->refutations[1] = quiet->killers[1];
+    // A countermove that is also a killer is tried only once
+    mp->refutations[2] = (move_equal(quiet->countermove, quiet->killers[0]) ||
+                          move_equal(quiet->countermove, quiet->killers[1])) ? NULL_MOVE : quiet->countermove;
+    mp->refutation_index = 0;
+    mp->count = 0;
+    mp->index = 0;
+    mp->bad_count = 0;
+    mp->bad_index = 0;
+    mp->stage = ai->checkers ? STAGE_EVASION_TT : STAGE_TT;
+}
+
+// Picker for quiescence search: tactical TT move, then captures and promotions
+void movepick_init_qsearch(MovePicker* mp, const Board* board, const AttackInfo* ai, Move tt_move) {
+    mp->board = board;
+    mp->ai = ai;
+    memset(&mp->quiet, 0, sizeof(mp->quiet));
+    mp->tt_move = (is_tactical(tt_move) && is_usable(mp, tt_move)) ? tt_move : NULL_MOVE;
+    for (int i = 0; i < 3; i++) mp->refutations[i] = NULL_MOVE;
+    mp->refutation_index = 0;
+    mp->count = 0;
+    mp->index = 0;
+    mp->bad_count = 0;
+    mp->bad_index = 0;
+    mp->stage = STAGE_QS_TT;
+}
+
+// Return the next move to search, or NULL_MOVE when all stages are exhausted
+Move movepick_next(MovePicker* mp) {
+    for (;;) {
+        switch (mp->stage) {
+            case STAGE_TT:
+            case STAGE_EVASION_TT:
+            case STAGE_QS_TT:
+                mp->stage++;
+                if (move_not_equal(mp->tt_move, NULL_MOVE)) return mp->tt_move;
+                break;
+
+            case STAGE_GEN_CAPTURES:
+            case STAGE_QS_GEN_CAPTURES:
+                generate_stage(mp, GEN_CAPTURES);
+                mp->stage++;
+                break;
+
+            case STAGE_GEN_QUIETS:
+                generate_stage(mp, GEN_QUIETS);
+                mp->stage++;
+                break;
+
+            case STAGE_GEN_EVASIONS:
+                generate_stage(mp, GEN_ALL);
+                mp->stage++;
+                break;
+
+            case STAGE_CAPTURES:
+                while (mp->index < mp->count) {
+                    Move move = select_best(mp);
+                    if (already_tried(mp, move)) continue;
+                    if (see_ge(mp->board, move, 0)) return move;
+                    mp->bad_captures[mp->bad_count++] = move;
+                }
+                mp->stage = STAGE_REFUTATIONS;
+                break;
+
+            case STAGE_QUIETS:
+            case STAGE_EVASIONS:
+            case STAGE_QS_CAPTURES:
+                while (mp->index < mp->count) {
+                    Move move = select_best(mp);
+                    if (!already_tried(mp, move)) return move;
+                }
+                mp->stage = (mp->stage == STAGE_QUIETS) ? STAGE_BAD_CAPTURES : STAGE_DONE;
+                break;
+
+            case STAGE_BAD_CAPTURES:
+                if (mp->bad_index < mp->bad_count) return mp->bad_captures[mp->bad_index++];
+                mp->stage = STAGE_DONE;
+                break;
+
+            case STAGE_REFUTATIONS:
+                while (mp->refutation_index < 3) {
+                    Move refutation = mp->refutations[mp->refutation_index++];
+                    if (!is_tactical(refutation) && move_not_equal(refutation, mp->tt_move) &&
+                        is_usable(mp, refutation)) {
+                        return refutation;
+                    }
+                }
+                mp->stage = STAGE_GEN_QUIETS;
+                break;
+
+            case STAGE_DONE:
+            default:
+                return NULL_MOVE;
+        }
+    }
+}
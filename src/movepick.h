@@ -0,0 +1,58 @@
+#ifndef MOVEPICK_H
+#define MOVEPICK_H
+
+#include "board.h"
+#include "move.h"
+#include "search.h"
+#include "attackinfo.h"
+
+// Move picker stages, in the order they are visited
+typedef enum {
+    STAGE_TT,
+    STAGE_GEN_CAPTURES,
+    STAGE_CAPTURES,
+    STAGE_REFUTATIONS,
+    STAGE_GEN_QUIETS,
+    STAGE_QUIETS,
+    STAGE_BAD_CAPTURES,
+    STAGE_EVASION_TT,
+    STAGE_GEN_EVASIONS,
+    STAGE_EVASIONS,
+    STAGE_QS_TT,
+    STAGE_QS_GEN_CAPTURES,
+    STAGE_QS_CAPTURES,
+    STAGE_DONE
+} PickStage;
+
+// Move with its ordering score, computed once when a stage is generated
+typedef struct {
+    Move move;
+    int score;
+} ScoredMove;
+
+// Yields legal moves one at a time, generating each stage only when the
+// earlier ones did not produce a cutoff. Within a stage the best remaining
+// move is found by selection when asked for, so nothing is fully sorted.
+// Captures that lose material by SEE are set aside and tried after the quiets.
+typedef struct {
+    const Board* board;
+    const AttackInfo* ai;
+    PickStage stage;
+    QuietOrdering quiet;          // Quiet move state of the node; unused in quiescence
+    Move tt_move;
+    Move refutations[3];          // Killers, then the countermove
+    int refutation_index;
+    ScoredMove moves[MAX_MOVES];
+    int count;
+    int index;
+    Move bad_captures[MAX_MOVES];  // Captures losing material, deferred until after the quiets
+    int bad_count;
+    int bad_index;
+} MovePicker;
+
+void movepick_init(MovePicker* mp, const Board* board, const AttackInfo* ai, Move tt_move,
+                   const QuietOrdering* quiet);
+void movepick_init_qsearch(MovePicker* mp, const Board* board, const AttackInfo* ai, Move tt_move);
+Move movepick_next(MovePicker* mp);
+
+#endif // MOVEPICK_H
@@ -0,0 +1,128 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "perft.h"
+#include "movegen.h"
+#include "search.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Perft hash entry. The key is stored XORed with the data so a torn write
+// from another thread fails the key check instead of returning a bad count.
+typedef struct {
+    uint64_t key_xor_data;
+    uint64_t data;           // node count << 8 | depth
+} PerftEntry;
+
+static PerftEntry* perft_table = NULL;
+static size_t perft_mask = 0;
+
+static uint64_t perft_hashed(Board* board, int depth) {
+    Move moves[MAX_MOVES];
+    if (depth == 1) return (uint64_t)generate_moves(board, moves);
+
+    // Moves are generated only when the table misses
+    PerftEntry* entry = NULL;
+    if (perft_table) {
+        entry = &perft_table[board->key & perft_mask];
+        uint64_t data = entry->data;
+        if ((entry->key_xor_data ^ data) == board->key && (int)(data & 0xFF) == depth) {
+            return data >> 8;
+        }
+    }
+
+    int count = generate_moves(board, moves);
+    uint64_t nodes = 0;
+    for (int i = 0; i < count; i++) {
+        board_make_move(board, moves[i]);
+        nodes += perft_hashed(board, depth - 1);
+        board_undo_move(board, moves[i]);
+    }
+
+    if (entry) {
+        uint64_t data = (nodes << 8) | (uint64_t)depth;
+        entry->data = data;
+        entry->key_xor_data = board->key ^ data;
+    }
+    return nodes;
+}
+
+uint64_t perft(Board* board, int depth) {
+    if (depth <= 0) return 1;
+    return perft_hashed(board, depth);
+}
+
+// Root moves are handed out one at a time from a shared index
+typedef struct {
+    const Board* root;
+    int depth;
+    const Move* moves;
+    uint64_t* counts;
+    int count;
+    int next;
+    pthread_mutex_t lock;
+} PerftJob;
+
+static void* perft_worker(void* arg) {
+    PerftJob* job = (PerftJob*)arg;
+    Board board = *job->root;
+
+    for (;;) {
+        pthread_mutex_lock(&job->lock);
+        int i = job->next++;
+        pthread_mutex_unlock(&job->lock);
+        if (i >= job->count) break;
+
+        board_make_move(&board, job->moves[i]);
+        job->counts[i] = perft(&board, job->depth - 1);
+        board_undo_move(&board, job->moves[i]);
+    }
+    return NULL;
+}
+
+int perft_divide(const Board* board, int depth, int threads, size_t hash_mb, Move* moves, uint64_t* counts) {
+    int count = generate_moves(board, moves);
+    if (depth <= 0) return 0;
+
+    if (hash_mb > 0) {
+        size_t entries = 1;
+        while (entries * 2 * sizeof(PerftEntry) <= hash_mb * 1024 * 1024) entries *= 2;
+        perft_table = calloc(entries, sizeof(PerftEntry));
+        perft_mask = entries - 1;
+    }
+
+    PerftJob job;
+    job.root = board;
+    job.depth = depth;
+    job.moves = moves;
+    job.counts = counts;
+    job.count = count;
+    job.next = 0;
+    pthread_mutex_init(&job.lock, NULL);
+
+    if (threads < 1) threads = 1;
+    if (threads > count) threads = count > 0 ? count : 1;
+
+    // Root moves left by workers that failed to start go to this thread
+    pthread_t workers[threads];
+    int started = 1;
+    for (; started < threads; started++) {
+        if (pthread_create(&workers[started], NULL, perft_worker, &job) != 0) break;
+    }
+    perft_worker(&job);
+    for (int t = 1; t < started; t++) {
+        pthread_join(workers[t], NULL);
+    }
+
+    pthread_mutex_destroy(&job.lock);
+    free(perft_table);
+    perft_table = NULL;
+    perft_mask = 0;
+    return count;
+}
+
+long perft_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
@@ -0,0 +1,21 @@
+#ifndef PERFT_H
+#define PERFT_H
+
+#include "board.h"
+#include "move.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Count leaf nodes of the legal move tree (moves at the last ply are
+// counted from the generator without being made)
+uint64_t perft(Board* board, int depth);
+
+// Per-root-move counts for 'perft'/'divide'. Root moves are shared out
+// between 'threads' workers; hash_mb > 0 enables a perft hash table of that
+// size. Fills moves/counts in generation order and returns the move count.
+int perft_divide(const Board* board, int depth, int threads, size_t hash_mb, Move* moves, uint64_t* counts);
+
+// Milliseconds from a monotonic clock
+long perft_time_ms(void);
+
+#endif // PERFT_H
@@ -1,321 +1,941 @@
+#define _POSIX_C_SOURCE 200809L  // clock_gettime under -std=c99
+
 #include "search.h"
 #include "movegen.h"
+#include "movepick.h"
+#include "see.h"
+#include "uci.h"
+#include "ybw.h"
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <time.h>
+
+// Lazy SMP state. Threads share nothing but the transposition table and the
+// stop flag; search_threads[0] is the main thread.
+static SearchThread search_threads[MAX_THREADS];
+static ContinuationHistory continuation_tables[MAX_THREADS];
+static int search_thread_count = 1;
+static int history_thread_count = 1;  // Threads whose ordering state may be set since the last clear
+static int search_deterministic;
+static int search_splitting;  // Deterministic mode is active for this search
+static int search_stop;
+
+// Limits of the running search. Times are in milliseconds from
+// search_start_time; zero means no limit.
+static long search_start_time;
+static long search_soft_limit;  // No iteration is started past half of this
+static long search_hard_limit;  // The search is aborted here
+static uint64_t search_node_limit;
+static int search_pondering;  // Limits are ignored until a ponderhit clears this
+
+// The stop flag and node counters are read by other threads while their
+// owner writes them; relaxed atomics are enough since no data rides on them
+#if defined(__GNUC__)
+#define RELAXED_LOAD(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define RELAXED_STORE(p, value) __atomic_store_n(p, value, __ATOMIC_RELAXED)
+#else
+#define RELAXED_LOAD(p) (*(volatile __typeof__(*(p))*)(p))
+#define RELAXED_STORE(p, value) (*(volatile __typeof__(*(p))*)(p) = (value))
+#endif
+
+static int search_stopped(void) {
+    return RELAXED_LOAD(&search_stop);
+}
+
+static uint64_t total_nodes(void) {
+    uint64_t nodes = 0;
+    for (int i = 0; i < search_thread_count; i++) {
+        nodes += RELAXED_LOAD(&search_threads[i].nodes);
+    }
+    return nodes;
+}
+
+// Every thread checks the clock and node limit once per TIME_CHECK_NODES of
+// its own nodes. The first iteration always completes, so there is a move to play.
+static void poll_limits(void) {
+    if (search_threads[0].result.depth == 0 || RELAXED_LOAD(&search_pondering)) return;
+    long elapsed = search_time_ms() - search_start_time;
+    if ((search_hard_limit && elapsed >= search_hard_limit) ||
+        (search_node_limit && total_nodes() >= search_node_limit)) {
+        RELAXED_STORE(&search_stop, 1);
+    }
+}
+
+static void count_node(SearchThread* thread) {
+    RELAXED_STORE(&thread->nodes, thread->nodes + 1);
+    if ((thread->nodes & (TIME_CHECK_NODES - 1)) == 0) poll_limits();
+}
+
+static void add_nodes(SearchThread* thread, uint64_t nodes) {
+    RELAXED_STORE(&thread->nodes, thread->nodes + nodes);
+}
+
+// Helpers skip some iterations so they are spread over several depths at once
+// rather than all repeating the main thread's. Helper i searches depth d unless
+// ((d + skip_phase[i]) / skip_size[i]) is odd, with i cycling through 20 patterns.
+#define SKIP_PATTERNS 20
+static const int skip_size[SKIP_PATTERNS]  = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+static const int skip_phase[SKIP_PATTERNS] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+static int skip_depth(const SearchThread* thread, int depth) {
+    if (thread->id == 0) return 0;
+    int i = (thread->id - 1) % SKIP_PATTERNS;
+    return ((depth + skip_phase[i]) / skip_size[i]) % 2;
+}
+
+// Mate scores are stored relative to the node rather than the root, so an
+// entry reached at a different ply still reports the right distance to mate
+static int score_to_tt(int score, int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static int score_from_tt(int score, int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+// Whether a stored bound already decides the result for this window
+static int tt_cutoff(const TTData* tt, int score, int alpha, int beta) {
+    switch (tt->flag) {
+        case TT_EXACT: return 1;
+        case TT_BETA:  return score >= beta;
+        case TT_ALPHA: return score <= alpha;
+        case TT_NONE:  break;
+    }
+    return 0;
+}
+
+// TT_VERIFY builds cut only on entries searched to exactly the requested depth,
+// so every node's value depends on the position alone, and each such cutoff is
+// re-searched with the table switched off. Disagreements are reported.
+// Verification assumes Threads is 1: helpers would change the table under it.
+#ifdef TT_VERIFY
+static long tt_verify_checks;
+static long tt_verify_failures;
+
+static void verify_tt_cutoff(SearchThread* thread, const TTData* tt, int depth, int ply, int alpha, int beta, int score) {
+    Board* board = &thread->board;
+
+    // Verification nodes are not part of the search and are not counted
+    uint64_t nodes = thread->nodes;
+    thread->verifying++;
+    int searched = depth > 0 ? alpha_beta_search(thread, depth, ply, alpha, beta)
+                             : quiescence_search(thread, ply, alpha, beta);
+    thread->verifying--;
+    thread->nodes = nodes;
+
+    // Both results must fall on the same side of the window, and agree inside it
+    tt_verify_checks++;
+    int ok = (searched <= alpha) ? score <= alpha : (searched >= beta) ? score >= beta : score == searched;
+    if (!ok) {
+        char fen[128];
+        board_get_fen(board, fen);
+        tt_verify_failures++;
+        printf("info string tt verify failure fen %s depth %d window %d %d stored depth %d flag %d score %d searched %d\n",
+               fen, depth, alpha, beta, tt->depth, (int)tt->flag, score, searched);
+    }
+}
+
+static int search_probe(const SearchThread* thread, int depth, TTData* tt) {
+    if (thread->verifying || !tt_probe(thread->board.key, tt)) return 0;
+    return tt->depth == depth;
+}
+
+#define search_store(thread, move, score, depth, flag) \
+    do { if (!(thread)->verifying) tt_store((thread)->board.key, move, score, depth, flag); } while (0)
+#else
+#define verify_tt_cutoff(thread, tt, depth, ply, alpha, beta, score) ((void)0)
+
+static int search_probe(const SearchThread* thread, int depth, TTData* tt) {
+    return tt_probe(thread->board.key, tt) && tt->depth >= depth;
+}
+
+#define search_store(thread, move, score, depth, flag) tt_store((thread)->board.key, move, score, depth, flag)
+#endif
+
+// Negamax scores are from the side to move; the evaluation is from White's
+static int evaluate_relative(const Board* board) {
+    int score = evaluate_position(board);
+    return board->side_to_move == WHITE ? score : -score;
+}
+
+int search_set_threads(int count) {
+    if (count < 1) count = 1;
+    if (count > MAX_THREADS) count = MAX_THREADS;
+    search_thread_count = count;
+    return count;
+}
+
+// Raised from any thread to end the running search. The caller lowers it
+// before starting a search, so a stop that arrives before the search thread
+// gets going still counts.
+void search_abort(void) {
+    RELAXED_STORE(&search_stop, 1);
+}
+
+void search_clear_abort(void) {
+    RELAXED_STORE(&search_stop, 0);
+}
+
+// A ponder search runs without limits. On ponderhit it carries on with the
+// limits of its go command, measured from when it started, so the time spent
+// pondering counts as already used and a long ponder ends quickly.
+void search_set_ponder(int pondering) {
+    RELAXED_STORE(&search_pondering, pondering);
+}
 
-// Global search state
-static int search_start_time;
-static int search_stop_time;
-int history_table[2][6][64];
+void search_set_deterministic(int enabled) {
+    search_deterministic = enabled;
+}
 
-// Search the position to the given depth
-SearchResult search_position(const Board* board, int depth) {
+// Forget all move ordering statistics, for a new game
+void search_clear_history(void) {
+    for (int i = 0; i < history_thread_count; i++) {
+        memset(search_threads[i].history, 0, sizeof(search_threads[i].history));
+        memset(search_threads[i].countermoves, 0, sizeof(search_threads[i].countermoves));
+        memset(continuation_tables[i], 0, sizeof(continuation_tables[i]));
+    }
+    history_thread_count = search_thread_count;
+}
+
+// Between searches the statistics are halved rather than cleared, so what
+// was learned about the previous position still orders the next one but
+// soon gives way to what is learned there
+static void decay_history(SearchThread* thread) {
+    int16_t* entry = &thread->history[0][0][0];
+    for (size_t i = 0; i < sizeof(thread->history) / sizeof(int16_t); i++) entry[i] /= 2;
+    entry = &(*thread->continuation)[0][0][0][0];
+    for (size_t i = 0; i < sizeof(*thread->continuation) / sizeof(int16_t); i++) entry[i] /= 2;
+}
+
+// Continuation history that follows the move searched back + 1 plies
+// before ply, or NULL when there is none
+static PieceToHistory* continuation_table(const SearchThread* thread, int ply, int back) {
+    if (ply <= back) return NULL;
+    const SearchStack* earlier = &thread->stack[ply - 1 - back];
+    if (move_equal(earlier->move, NULL_MOVE)) return NULL;
+    return &(*thread->continuation)[earlier->piece][move_to(earlier->move)];
+}
+
+// Gather the quiet move ordering state of the node at ply
+static void quiet_ordering(const SearchThread* thread, int ply, QuietOrdering* quiet) {
+    quiet->killers[0] = thread->stack[ply].killers[0];
+    quiet->killers[1] = thread->stack[ply].killers[1];
+    quiet->countermove = NULL_MOVE;
+    quiet->history = &thread->history;
+    for (int i = 0; i < CONTINUATION_PLIES; i++) {
+        quiet->continuation[i] = continuation_table(thread, ply, i);
+    }
+    if (ply > 0 && move_not_equal(thread->stack[ply - 1].move, NULL_MOVE)) {
+        const SearchStack* previous = &thread->stack[ply - 1];
+        quiet->countermove = thread->countermoves[previous->piece][move_to(previous->move)];
+    }
+}
+
+// In deterministic mode a node deep enough hands the moves after its first
+// few to the YBW scheduler (see ybw.h), whether or not other threads are
+// free, so the tree searched never depends on the thread count
+static int should_split(int depth, int searched) {
+    return search_splitting && depth >= YBW_SPLIT_DEPTH && searched == YBW_SPLIT_AFTER;
+}
+
+// Drain the picker and scout the moves left as split point tasks, with a
+// null window at alpha; returns how many there were
+static int split_remaining(SearchThread* thread, MovePicker* picker, int depth, int ply, int alpha,
+                           Move* moves, int* scores) {
+    int count = 0;
+    Move move;
+    while (move_not_equal(move = movepick_next(picker), NULL_MOVE)) {
+        moves[count++] = move;
+    }
+    if (count > 0) {
+        add_nodes(thread, ybw_search_moves(thread, depth, ply, alpha, alpha + 1, moves, count, scores));
+    }
+    return count;
+}
+
+// The node at ply found a new best move: its line is that move followed by
+// the line of the child it led to
+static void update_pv(SearchThread* thread, int ply, Move move) {
+    PVLine* line = &thread->pv[ply];
+    const PVLine* child = &thread->pv[ply + 1];
+    line->moves[0] = move;
+    memcpy(line->moves + 1, child->moves, child->length * sizeof(Move));
+    line->length = child->length + 1;
+}
+
+// The move of the previous iteration's PV at this ply while the search is
+// still on that line, to be tried first; NULL_MOVE once it has left it
+static Move previous_pv_move(SearchThread* thread, int ply) {
+    if (!thread->follow_pv) return NULL_MOVE;
+    if (ply < thread->result.pv_length) return thread->result.pv[ply];
+    thread->follow_pv = 0;
+    return NULL_MOVE;
+}
+
+// A line cut short by a table hit is continued with the table's moves, as
+// long as each is legal and no position repeats, up to the search depth
+static void extend_pv(const Board* root, SearchResult* result) {
+    Board board = *root;
+    uint64_t keys[MAX_DEPTH + 1];
+    keys[0] = board.key;
+    for (int i = 0; i < result->pv_length; i++) {
+        board_make_move(&board, result->pv[i]);
+        keys[i + 1] = board.key;
+    }
+
+    while (result->pv_length < result->depth) {
+        TTData tt;
+        if (!tt_probe(board.key, &tt) || move_equal(tt.best_move, NULL_MOVE)) return;
+        Move moves[MAX_MOVES];
+        int count = generate_moves(&board, moves);
+        int legal = 0;
+        for (int i = 0; i < count && !legal; i++) legal = move_equal(moves[i], tt.best_move);
+        if (!legal) return;
+
+        board_make_move(&board, tt.best_move);
+        for (int i = 0; i <= result->pv_length; i++) {
+            if (keys[i] == board.key) return;
+        }
+        result->pv[result->pv_length++] = tt.best_move;
+        keys[result->pv_length] = board.key;
+    }
+}
+
+// Principal variation search of one move at a node: with the full window
+// when scout is 0, otherwise with a null window at alpha first, repeated in
+// full only when the move beats alpha without reaching beta
+int search_move(SearchThread* thread, Move move, int depth, int ply, int alpha, int beta, int scout) {
+    Board* board = &thread->board;
+    thread->stack[ply].move = move;
+    thread->stack[ply].piece = board->piece_on[move_from(move)];
+    board_make_move(board, move);
+    int score;
+    if (scout) {
+        score = -alpha_beta_search(thread, depth - 1, ply + 1, -alpha - 1, -alpha);
+        if (score > alpha && score < beta && !search_stopped()) {
+            score = -alpha_beta_search(thread, depth - 1, ply + 1, -beta, -alpha);
+        }
+    } else {
+        score = -alpha_beta_search(thread, depth - 1, ply + 1, -beta, -alpha);
+    }
+    board_undo_move(board, move);
+    return score;
+}
+
+// Search the thread's root position to the given depth within (alpha, beta).
+// A score at or outside the window is only a bound. A result cut short by
+// the stop flag is incomplete and must be discarded by the caller.
+SearchResult search_position(SearchThread* thread, int depth, int alpha, int beta) {
+    Board* board = &thread->board;
     SearchResult result;
     result.best_move = NULL_MOVE;
     result.score = 0;
     result.depth = depth;
     result.nodes = 0;
     result.time_ms = 0;
-    
+    result.pv_length = 0;
+
     if (depth <= 0) {
-        result.score = evaluate_position(board);
+        result.score = evaluate_relative(board);
         return result;
     }
-    
-    // Generate all legal moves (our new movegen only returns legal moves)
-    Move moves[MAX_MOVES];
-    int move_count = generate_moves(board, moves);
-    
-    if (move_count == 0) {
-        // Checkmate or stalemate
-        if (board_is_check(board)) {
-            result.score = -MATE_SCORE;
+
+    // Root moves come from the same picker as the rest of the tree. The
+    // previous iteration's line is searched first, ahead of the table's move.
+    AttackInfo ai;
+    attack_info_init(board, &ai);
+    thread->follow_pv = 1;
+    thread->pv[0].length = 0;
+    Move first = previous_pv_move(thread, 0);
+    TTData tt;
+    if (move_equal(first, NULL_MOVE) && tt_probe(board->key, &tt)) first = tt.best_move;
+    QuietOrdering quiet;
+    quiet_ordering(thread, 0, &quiet);
+    MovePicker picker;
+    movepick_init(&picker, board, &ai, first, &quiet);
+
+    int original_alpha = alpha;
+    int best_score = -INFINITY;
+    int move_count = 0;
+    Move move;
+    Move split_moves[MAX_MOVES];
+    int split_scores[MAX_MOVES];
+    int split_count = -1;  // Moves handed to the scheduler, once the node has split
+    int split_index = 0;
+    int split_alpha = alpha;
+
+    for (;;) {
+        int score;
+        if (split_count < 0) {
+            if (move_equal(move = movepick_next(&picker), NULL_MOVE)) break;
+            if (move_not_equal(move, first)) thread->follow_pv = 0;
+            score = search_move(thread, move, depth, 0, alpha, beta, move_count > 0);
         } else {
-            result.score = 0;
+            if (split_index == split_count) break;
+            move = split_moves[split_index];
+            score = split_scores[split_index++];
+            // A move that beat the scout's bound is searched again, in order;
+            // once alpha has moved on, that starts with a new scout. A task
+            // leaves no line, so the move has none unless searched here.
+            thread->pv[1].length = 0;
+            if (score > split_alpha && split_alpha + 1 < beta) {
+                score = search_move(thread, move, depth, 0, alpha, beta, alpha > split_alpha);
+            }
         }
-        return result;
-    }
-    
-    // Order moves
-    order_moves(board, moves, move_count);
-    
-    // Search with alpha-beta
-    int alpha = -INFINITY;
-    int beta = INFINITY;
-    int best_score = -INFINITY;
-    
-    for (int i = 0; i < move_count; i++) {
-        Board temp_board = *board;
-        board_make_move(&temp_board, moves[i]);
-        
-        int score = -alpha_beta_search(&temp_board, depth - 1, -beta, -alpha, &result.nodes);
-        
+        move_count++;
+
+        if (search_stopped()) {
+            result.nodes = thread->nodes;
+            return result;
+        }
+
         if (score > best_score) {
             best_score = score;
-            result.best_move = moves[i];
+            result.best_move = move;
         }
-        
+
         if (score > alpha) {
             alpha = score;
+            update_pv(thread, 0, move);
         }
-        
+
         if (alpha >= beta) {
             break; // Beta cutoff
         }
+
+        if (should_split(depth, move_count)) {
+            split_alpha = alpha;
+            split_count = split_remaining(thread, &picker, depth, 0, alpha, split_moves, split_scores);
+        }
     }
-    
+
+    result.nodes = thread->nodes;
+
+    // Checkmate or stalemate
+    if (move_count == 0) {
+        result.score = ai.checkers ? -MATE_SCORE : 0;
+        return result;
+    }
+
+    TTFlag flag = best_score >= beta ? TT_BETA : best_score > original_alpha ? TT_EXACT : TT_ALPHA;
+    search_store(thread, result.best_move, score_to_tt(best_score, 0), depth, flag);
+
+    // A root that failed low has no line; its best guess stands alone
+    if (thread->pv[0].length > 0) {
+        result.pv_length = thread->pv[0].length;
+        memcpy(result.pv, thread->pv[0].moves, result.pv_length * sizeof(Move));
+    } else {
+        result.pv[0] = result.best_move;
+        result.pv_length = 1;
+    }
+    extend_pv(board, &result);
+
+#ifdef TT_VERIFY
+    printf("info string tt verify checks %ld failures %ld\n", tt_verify_checks, tt_verify_failures);
+#endif
+
     result.score = best_score;
     return result;
 }
 
-// Iterative deepening with time management
+// Search an iteration in a window spanning the thread's last two scores,
+// which this evaluation makes swing with the parity of the depth. A score
+// outside it is searched again with that side widened by a margin that doubles
+// each time (the other side is pulled in halfway) until it lands inside; mates and
+// shallow iterations get the full window.
+static SearchResult aspiration_search(SearchThread* thread, int depth) {
+    int last = thread->result.score;
+    int prior = thread->prior_score;
+    if (depth < ASPIRATION_DEPTH || thread->result.depth == 0 ||
+        last > MATE_BOUND || last < -MATE_BOUND || prior > MATE_BOUND || prior < -MATE_BOUND) {
+        return search_position(thread, depth, -INFINITY, INFINITY);
+    }
+
+    int delta = ASPIRATION_WINDOW;
+    int alpha = (last < prior ? last : prior) - delta;
+    int beta = (last > prior ? last : prior) + delta;
+    for (;;) {
+        SearchResult result = search_position(thread, depth, alpha, beta);
+        if (search_stopped()) return result;
+        delta += delta;
+        if (result.score <= alpha) {
+            beta = (alpha + beta) / 2;
+            alpha = result.score - delta > -INFINITY ? result.score - delta : -INFINITY;
+        } else if (result.score >= beta) {
+            beta = result.score + delta < INFINITY ? result.score + delta : INFINITY;
+        } else {
+            return result;
+        }
+    }
+}
+
+// Keep a finished iteration, and the score before it for the next window
+static void complete_iteration(SearchThread* thread, const SearchResult* result) {
+    thread->prior_score = thread->result.depth > 0 ? thread->result.score : result->score;
+    thread->result = *result;
+}
+
+// Helpers deepen without limit until the main thread raises the stop flag
+static void* helper_main(void* arg) {
+    SearchThread* thread = (SearchThread*)arg;
+    for (int depth = 1; depth < MAX_DEPTH && !search_stopped(); depth++) {
+        if (skip_depth(thread, depth)) continue;
+        SearchResult current = aspiration_search(thread, depth);
+        if (search_stopped()) break;
+        complete_iteration(thread, &current);
+    }
+    return NULL;
+}
+
+// Each thread proposes the best move of its deepest completed iteration.
+// Proposals are weighted by depth and by score above the worst one, and the
+// move with the most weight wins; ties go to the main thread.
+static const SearchThread* vote_best_thread(void) {
+    const SearchThread* best = &search_threads[0];
+    int min_score = INFINITY;
+    for (int i = 0; i < search_thread_count; i++) {
+        const SearchResult* r = &search_threads[i].result;
+        if (r->depth > 0 && r->score < min_score) min_score = r->score;
+    }
+
+    long best_votes = -1;
+    for (int i = 0; i < search_thread_count; i++) {
+        const SearchResult* r = &search_threads[i].result;
+        if (r->depth == 0 || move_equal(r->best_move, NULL_MOVE)) continue;
+        long votes = 0;
+        for (int j = 0; j < search_thread_count; j++) {
+            const SearchResult* other = &search_threads[j].result;
+            if (other->depth > 0 && move_equal(other->best_move, r->best_move)) {
+                votes += (long)(other->score - min_score + 14) * other->depth;
+            }
+        }
+        if (votes > best_votes) {
+            best_votes = votes;
+            best = &search_threads[i];
+        }
+    }
+    return best;
+}
+
+// Space-separated moves of the result's PV
+static void pv_to_string(const SearchResult* result, char* out) {
+    out[0] = '\0';
+    for (int i = 0; i < result->pv_length; i++) {
+        if (i > 0) *out++ = ' ';
+        move_to_string(result->pv[i], out);
+        out += strlen(out);
+    }
+}
+
+// Iterative deepening on all threads; the main thread decides when to stop
 SearchResult iterative_deepening(const Board* board, int max_depth, const TimeControl* tc) {
-    SearchResult result;
-    result.best_move = NULL_MOVE;
-    result.score = 0;
-    result.depth = 0;
-    result.nodes = 0;
-    result.time_ms = 0;
-    
-    // Clear history table
-    memset(history_table, 0, sizeof(history_table));
-    
-    // Start with depth 1 and increase
+    SearchResult empty;
+    empty.best_move = NULL_MOVE;
+    empty.score = 0;
+    empty.depth = 0;
+    empty.nodes = 0;
+    empty.time_ms = 0;
+    empty.pv_length = 0;
+
+    // Every thread starts from its own copy of the root with its own ordering state
+    if (search_thread_count > history_thread_count) history_thread_count = search_thread_count;
+    for (int i = 0; i < search_thread_count; i++) {
+        SearchThread* thread = &search_threads[i];
+        thread->board = *board;
+        thread->continuation = &continuation_tables[i];
+        decay_history(thread);
+        memset(thread->stack, 0, sizeof(thread->stack));
+        thread->result = empty;
+        thread->prior_score = 0;
+        thread->follow_pv = 0;
+        thread->null_min_ply = 0;
+        thread->id = i;
+        thread->split = NULL;
+#ifdef TT_VERIFY
+        thread->verifying = 0;
+#endif
+        thread->nodes = 0;
+    }
+
+    search_start_time = search_time_ms();
+    int soft, hard;
+    get_search_time(tc, board->side_to_move, &soft, &hard);
+    search_soft_limit = soft;
+    search_hard_limit = hard;
+    search_node_limit = tc->nodes > 0 ? (uint64_t)tc->nodes : 0;
+
+    // Deterministic search holds back this search's table stores until each
+    // iteration ends; without memory for that it falls back to Lazy SMP
+    search_splitting = search_deterministic;
+    if (search_splitting && tt_set_deferred(1) != 0) {
+        printf("info string cannot allocate deterministic search table, using lazy smp\n");
+        search_splitting = 0;
+    }
+
+    pthread_t helpers[MAX_THREADS];
+    int started = 1;
+    if (search_splitting) {
+        started = ybw_start(search_thread_count);
+    } else {
+        for (; started < search_thread_count; started++) {
+            if (pthread_create(&helpers[started], NULL, helper_main, &search_threads[started]) != 0) break;
+        }
+    }
+
+    SearchThread* main_thread = &search_threads[0];
     for (int depth = 1; depth <= max_depth; depth++) {
-        SearchResult current_result = search_position(board, depth);
-        
+        SearchResult current = aspiration_search(main_thread, depth);
+        if (search_splitting) tt_commit();
+
+        // An aborted iteration is thrown away; the last completed one stands
+        if (search_stopped()) {
+            break;
+        }
+
+        long elapsed = search_time_ms() - search_start_time;
+        uint64_t nodes = total_nodes();
+        current.time_ms = (int)elapsed;
+        complete_iteration(main_thread, &current);
+
+        // One printf per line, so lines from other threads cannot split it
+        char pv[MAX_DEPTH * 6];
+        pv_to_string(&current, pv);
+        printf("info depth %d score cp %d nodes %llu time %ld nps %llu pv %s\n", depth, current.score,
+               (unsigned long long)nodes, elapsed, (unsigned long long)(nodes * 1000 / (elapsed + 1)), pv);
+        // Human-friendly decimal eval line
+        printf("info string eval %+.2f\n", current.score / 100.0);
+        fflush(stdout);
+
         // Check if we should stop
         if (should_stop_search(tc)) {
             break;
         }
-        
-        // Update result
-        result = current_result;
-        result.depth = depth;
-        
-        // Print info
-        printf("info depth %d score cp %d nodes %d\n", 
-               depth, result.score, result.nodes);
-    }
-    
+    }
+
+    RELAXED_STORE(&search_stop, 1);
+    if (search_splitting) {
+        ybw_stop();
+        tt_set_deferred(0);
+    } else {
+        for (int i = 1; i < started; i++) {
+            pthread_join(helpers[i], NULL);
+        }
+    }
+
+    const SearchThread* best = vote_best_thread();
+    SearchResult result = best->result;
+    result.nodes = total_nodes();
+
+    // A helper's move won the vote; report its line so the GUI shows what is played
+    if (best != main_thread) {
+        long elapsed = search_time_ms() - search_start_time;
+        char pv[MAX_DEPTH * 6];
+        pv_to_string(&result, pv);
+        printf("info depth %d score cp %d nodes %llu time %ld nps %llu pv %s\n", result.depth, result.score,
+               (unsigned long long)result.nodes, elapsed,
+               (unsigned long long)(result.nodes * 1000 / (elapsed + 1)), pv);
+        fflush(stdout);
+    }
+    if (started < search_thread_count) {
+        printf("info string started %d of %d threads\n", started, search_thread_count);
+    }
     return result;
 }
 
+// Null move pruning is tried only at scout nodes, out of check, when the
+// side to move has a piece besides pawns (pawn endings are full of
+// zugzwang, where passing would be best) and did not just get a free move
+// itself. A verification search in progress turns it off for that side
+// near the node being verified. TT_VERIFY builds never prune this way:
+// whether a null move is tried depends on the path to the node, and those
+// builds need every node's value to depend on the position alone.
+static int null_move_allowed(const SearchThread* thread, const AttackInfo* ai, int depth, int ply, int alpha, int beta) {
+#ifdef TT_VERIFY
+    (void)thread; (void)ai; (void)depth; (void)ply; (void)alpha; (void)beta;
+    return 0;
+#endif
+    const Board* board = &thread->board;
+    Color us = board->side_to_move;
+    if (depth < NULL_MOVE_MIN_DEPTH || beta - alpha > 1 || ai->checkers) return 0;
+    if (beta >= MATE_BOUND || beta <= -MATE_BOUND) return 0;
+    if (ply > 0 && move_equal(thread->stack[ply - 1].move, NULL_MOVE)) return 0;
+    if (ply < thread->null_min_ply && us == thread->null_color) return 0;
+    return (board->by_color[us] & ~(board->pieces[us][PAWN] | board->pieces[us][KING])) != 0;
+}
+
+// Give the opponent a free move and search the reply at reduced depth. If
+// we still reach beta, a real move almost certainly would, and the node
+// fails high. The reduction grows with depth and with how far the static
+// evaluation is above beta. Deep nodes confirm the cutoff with a normal
+// search to the same reduced depth, without null moves for this side.
+// Returns the score to fail high with, or -INFINITY to search normally.
+static int null_move_prune(SearchThread* thread, AttackInfo* ai, int depth, int ply, int beta) {
+    Board* board = &thread->board;
+    int eval = evaluate_with_attacks(board, ai);
+    if (board->side_to_move == BLACK) eval = -eval;
+    if (eval < beta) return -INFINITY;
+
+    int margin = (eval - beta) / NULL_MOVE_EVAL_STEP;
+    int reduction = NULL_MOVE_R + depth / 6 + (margin < 3 ? margin : 3);
+    int null_depth = depth - 1 - reduction;
+
+    int score = null_move_search(thread, null_depth, ply, beta - 1, beta);
+    if (search_stopped() || score < beta) return -INFINITY;
+    if (score >= MATE_BOUND) score = beta;  // A mate found by passing is not proven
+    if (depth < NULL_MOVE_VERIFY_DEPTH || thread->null_min_ply) return score;
+
+    thread->null_min_ply = ply + 3 * (null_depth > 0 ? null_depth : 0) / 4;
+    thread->null_color = board->side_to_move;
+    int verified = alpha_beta_search(thread, null_depth, ply, beta - 1, beta);
+    thread->null_min_ply = 0;
+    return verified >= beta ? score : -INFINITY;
+}
+
 // Alpha-beta search with advanced pruning
-int alpha_beta_search(const Board* board, int depth, int alpha, int beta, int* nodes) {
-    if (nodes) (*nodes)++;
-    
-    // Check for terminal positions
-    if (board_is_checkmate(board)) {
-        return -MATE_SCORE;
-    }
-    
-    if (board_is_stalemate(board)) {
-        return 0;
-    }
-    
-    // Transposition table disabled for stability
-    // uint64_t hash = generate_hash(board);
-    
+int alpha_beta_search(SearchThread* thread, int depth, int ply, int alpha, int beta) {
+    Board* board = &thread->board;
+    thread->pv[ply].length = 0;
+    count_node(thread);
+    if (search_stopped()) return 0;
+
     // Quiescence search at leaf nodes
     if (depth <= 0) {
-        return quiescence_search(board, alpha, beta, nodes);
-    }
-    
-    // Generate legal moves (no need to filter - our movegen only returns legal moves)
-    Move moves[MAX_MOVES];
-    int move_count = generate_moves(board, moves);
-    
-    if (move_count == 0) {
+        // Checkmate is still recognised at the horizon; only evasions are needed
         if (board_is_check(board)) {
-            return -MATE_SCORE;
-        } else {
-            return 0;
+            Move evasions[MAX_MOVES];
+            if (generate_evasions(board, evasions) == 0) {
+                return -MATE_SCORE + ply;
+            }
         }
+        return quiescence_search(thread, ply, alpha, beta);
+    }
+
+    // A deep enough entry whose bound settles this window ends the node;
+    // otherwise its move is still searched first
+    TTData tt;
+    tt.best_move = NULL_MOVE;
+    tt.flag = TT_NONE;
+    if (search_probe(thread, depth, &tt)) {
+        int tt_score = score_from_tt(tt.score, ply);
+        if (tt_cutoff(&tt, tt_score, alpha, beta)) {
+            verify_tt_cutoff(thread, &tt, depth, ply, alpha, beta, tt_score);
+            return tt_score;
+        }
+    }
+
+    // Moves are generated stage by stage so an early cutoff skips the rest;
+    // all stages share this node's attack maps
+    AttackInfo ai;
+    attack_info_init(board, &ai);
+
+    if (null_move_allowed(thread, &ai, depth, ply, alpha, beta)) {
+        int score = null_move_prune(thread, &ai, depth, ply, beta);
+        if (score >= beta) return score;
     }
-    
-    // Order moves
-    order_moves(board, moves, move_count);
-    
+
+    Move pv_move = previous_pv_move(thread, ply);
+    QuietOrdering quiet;
+    quiet_ordering(thread, ply, &quiet);
+    MovePicker picker;
+    movepick_init(&picker, board, &ai, move_equal(pv_move, NULL_MOVE) ? tt.best_move : pv_move, &quiet);
+
     int best_score = -INFINITY;
     Move best_move = NULL_MOVE;
     TTFlag tt_flag = TT_ALPHA;
-    
-    for (int i = 0; i < move_count; i++) {
-        Board temp_board = *board;
-        board_make_move(&temp_board, moves[i]);
-        
-        int score = -alpha_beta_search(&temp_board, depth - 1, -beta, -alpha, nodes);
-        
+    int move_count = 0;
+    Move move;
+    Move split_moves[MAX_MOVES];
+    int split_scores[MAX_MOVES];
+    int split_count = -1;  // Moves handed to the scheduler, once the node has split
+    int split_index = 0;
+    int split_alpha = alpha;
+    Move quiets[MAX_MOVES];  // Quiet moves searched without a cutoff
+    int quiet_count = 0;
+
+    for (;;) {
+        int score;
+        if (split_count < 0) {
+            if (move_equal(move = movepick_next(&picker), NULL_MOVE)) break;
+            if (move_not_equal(move, pv_move)) thread->follow_pv = 0;
+            score = search_move(thread, move, depth, ply, alpha, beta, move_count > 0);
+        } else {
+            if (split_index == split_count) break;
+            move = split_moves[split_index];
+            score = split_scores[split_index++];
+            thread->pv[ply + 1].length = 0;
+            if (score > split_alpha && split_alpha + 1 < beta) {
+                score = search_move(thread, move, depth, ply, alpha, beta, alpha > split_alpha);
+            }
+        }
+        move_count++;
+
+        // An aborted child's score means nothing; leave the table untouched
+        if (search_stopped()) return 0;
+
         if (score > best_score) {
             best_score = score;
-            best_move = moves[i];
+            best_move = move;
         }
-        
+
         if (score > alpha) {
             alpha = score;
             tt_flag = TT_EXACT;
+            update_pv(thread, ply, move);
         }
-        
+
         if (alpha >= beta) {
             tt_flag = TT_BETA;
-            update_history(board, moves[i], depth);
+            if (!is_capture(move) && !is_promotion(move)) {
+                update_quiet_stats(thread, ply, move, depth, quiets, quiet_count);
+            }
             break; // Beta cutoff
         }
+        if (!is_capture(move) && !is_promotion(move)) quiets[quiet_count++] = move;
+
+        // A stored lower bound marks an expected cut node, where the rest of the moves are likely wasted
+        if (should_split(depth, move_count) && tt.flag != TT_BETA) {
+            split_alpha = alpha;
+            split_count = split_remaining(thread, &picker, depth, ply, alpha, split_moves, split_scores);
+        }
     }
-    
-    // Transposition table disabled for stability
-    // tt_store(hash, best_move, best_score, depth, tt_flag);
-    
+
+    // No legal moves: checkmate or stalemate
+    if (move_count == 0) {
+        return ai.checkers ? -MATE_SCORE + ply : 0;
+    }
+
+    search_store(thread, best_move, score_to_tt(best_score, ply), depth, tt_flag);
+
     return best_score;
 }
 
-// Null move search
-int null_move_search(const Board* board, int depth, int alpha, int beta, int* nodes) {
-    Board temp_board = *board;
-    temp_board.side_to_move = color_opposite(temp_board.side_to_move);
-    
-    return -alpha_beta_search(&temp_board, depth, -beta, -alpha, nodes);
+// Search the position after passing the move, to the given depth
+int null_move_search(SearchThread* thread, int depth, int ply, int alpha, int beta) {
+    thread->stack[ply].move = NULL_MOVE;
+    thread->stack[ply].piece = 0;
+    board_make_null_move(&thread->board);
+    int score = -alpha_beta_search(thread, depth, ply + 1, -beta, -alpha);
+    board_undo_null_move(&thread->board);
+
+    return score;
 }
 
 // Futility pruning
 int futility_pruning(const Board* board, int depth, int alpha, int beta) {
-    int eval = evaluate_position(board);
-    
+    int eval = evaluate_relative(board);
+
     if (eval - FUTILITY_MARGIN * depth >= beta) {
         return beta;
     }
-    
+
     return 0; // Continue search
 }
 
 // Razor pruning
-int razor_pruning(const Board* board, int depth, int alpha, int beta) {
-    int eval = evaluate_position(board);
-    
+int razor_pruning(SearchThread* thread, int depth, int ply, int alpha, int beta) {
+    Board* board = &thread->board;
+    int eval = evaluate_relative(board);
+
     if (eval + RAZOR_MARGIN <= alpha) {
         // Only search captures
         Move moves[MAX_MOVES];
-        int move_count = generate_moves(board, moves);
-        
+        int move_count = generate_captures(board, moves);
+
         int best_score = eval;
         for (int i = 0; i < move_count; i++) {
             if (is_capture(moves[i])) {
-                Board temp_board = *board;
-                board_make_move(&temp_board, moves[i]);
-                
-                int dummy_nodes = 0; // local counter to avoid undeclared 'nodes'
-                int score = -alpha_beta_search(&temp_board, depth - 1, -beta, -alpha, &dummy_nodes);
+                board_make_move(board, moves[i]);
+                int score = -alpha_beta_search(thread, depth - 1, ply + 1, -beta, -alpha);
+                board_undo_move(board, moves[i]);
                 if (score > best_score) {
                     best_score = score;
                 }
             }
         }
-        
+
         if (best_score <= alpha) {
             return alpha;
         }
     }
-    
+
     return 0; // Continue search
 }
 
 // Quiescence search (captures only)
-int quiescence_search(const Board* board, int alpha, int beta, int* nodes) {
-    if (nodes) (*nodes)++;
-    
-    int stand_pat = evaluate_position(board);
-    
+int quiescence_search(SearchThread* thread, int ply, int alpha, int beta) {
+    Board* board = &thread->board;
+    count_node(thread);
+    if (search_stopped()) return 0;
+
+    // Every entry is deep enough here; quiescence results are stored at depth 0
+    TTData tt;
+    tt.best_move = NULL_MOVE;
+    if (search_probe(thread, 0, &tt)) {
+        int tt_score = score_from_tt(tt.score, ply);
+        if (tt_cutoff(&tt, tt_score, alpha, beta)) {
+            verify_tt_cutoff(thread, &tt, 0, ply, alpha, beta, tt_score);
+            return tt_score;
+        }
+    }
+
+    // One set of attack maps serves the evaluation and the capture generator
+    AttackInfo ai;
+    attack_info_init(board, &ai);
+    int stand_pat = evaluate_with_attacks(board, &ai);
+    if (board->side_to_move == BLACK) stand_pat = -stand_pat;
+
+    // Fail-soft: bounds come back as the score found rather than alpha or
+    // beta, so a failed aspiration window knows how far to widen
     if (stand_pat >= beta) {
-        return beta;
+        return stand_pat;
     }
-    
+
+    int original_alpha = alpha;
+    int best_score = stand_pat;
     if (alpha < stand_pat) {
         alpha = stand_pat;
     }
-    
-    // Generate only captures (our movegen returns only legal moves)
-    Move moves[MAX_MOVES];
-    int move_count = generate_moves(board, moves);
-    
-    // Filter to captures only (no need to check legality again)
-    int capture_count = 0;
-    for (int i = 0; i < move_count; i++) {
-        if (is_capture(moves[i])) {
-            moves[capture_count++] = moves[i];
-        }
-    }
-    
-    if (capture_count == 0) {
-        return stand_pat;
-    }
-    
-    // Order captures
-    order_moves(board, moves, capture_count);
-    
-    for (int i = 0; i < capture_count; i++) {
-        Board temp_board = *board;
-        board_make_move(&temp_board, moves[i]);
-        
-        int score = -quiescence_search(&temp_board, -beta, -alpha, nodes);
-        
+
+    // Captures and promotions only; quiet moves are never generated here
+    Move best_move = NULL_MOVE;
+    MovePicker picker;
+    movepick_init_qsearch(&picker, board, &ai, tt.best_move);
+
+    Move move;
+    while (move_not_equal(move = movepick_next(&picker), NULL_MOVE)) {
+        // Captures that lose material by SEE are not worth searching here
+        if (!is_promotion(move) && !see_ge(board, move, 0)) continue;
+
+        board_make_move(board, move);
+        int score = -quiescence_search(thread, ply + 1, -beta, -alpha);
+        board_undo_move(board, move);
+
+        if (search_stopped()) return 0;
+
         if (score >= beta) {
-            return beta;
-        }
-        
-        if (score > alpha) {
-            alpha = score;
-        }
-    }
-    
-    return alpha;
-}
-
-// Order moves for better alpha-beta pruning
-void order_moves(const Board* board, Move* moves, int count) {
-    // Get transposition table move
-    uint64_t hash = generate_hash(board);
-    TTEntry* tt_entry = tt_probe(hash);
-    Move tt_move = tt_entry ? tt_entry->best_move : NULL_MOVE;
-    
-    // Score moves
-    int scores[MAX_MOVES];
-    for (int i = 0; i < count; i++) {
-        scores[i] = get_move_score(board, moves[i]);
-        
-        // Bonus for transposition table move
-        if (moves[i].data == tt_move.data) {
-            scores[i] += 10000;
+            search_store(thread, move, score_to_tt(score, ply), 0, TT_BETA);
+            return score;
         }
-        
-        // Bonus for history
-        Square from = move_from(moves[i]);
-        PieceType piece = PAWN;
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
-            if (test_bit(board->pieces[board->side_to_move][pt], from)) {
-                piece = pt;
-                break;
-            }
-        }
-        scores[i] += history_table[board->side_to_move][piece][from];
-    }
-    
-    // Sort moves by score (bubble sort for simplicity)
-    for (int i = 0; i < count - 1; i++) {
-        for (int j = i + 1; j < count; j++) {
-            if (scores[j] > scores[i]) {
-                // Swap moves
-                Move temp_move = moves[i];
-                moves[i] = moves[j];
-                moves[j] = temp_move;
-                
-                // Swap scores
-                int temp_score = scores[i];
-                scores[i] = scores[j];
-                scores[j] = temp_score;
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = move;
             }
         }
     }
+
+    // Raised above the original alpha (by a capture or the stand pat) the score is exact
+    search_store(thread, best_move, score_to_tt(best_score, ply), 0,
+                 best_score > original_alpha ? TT_EXACT : TT_ALPHA);
+    return best_score;
 }
 
 // Get move score for ordering (MVV-LVA)
@@ -324,23 +944,11 @@ int get_move_score(const Board* board, Move move) {
     Square to = move_to(move);
 
     // Determine moving piece
-    PieceType piece = PAWN;
-    for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
-        if (test_bit(board->pieces[board->side_to_move][pt], from)) {
-            piece = pt;
-            break;
-        }
-    }
+    PieceType piece = (PieceType)board->piece_on[from];
 
     // Captures: MVV-LVA
     if (is_capture(move)) {
-        PieceType victim = PAWN;
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
-            if (test_bit(board->pieces[color_opposite(board->side_to_move)][pt], to)) {
-                victim = pt;
-                break;
-            }
-        }
+        PieceType victim = is_en_passant(move) ? PAWN : (PieceType)board->piece_on[to];
         int victim_values[] = {PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE};
         int attacker_values[] = {PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE};
         return 6 * victim_values[victim] - attacker_values[piece];
@@ -413,24 +1021,53 @@ int get_move_score(const Board* board, Move move) {
         default: break;
     }
 
-    // Include history heuristic for quiet moves
-    score += history_table[board->side_to_move][piece][from];
-
     return score;
 }
 
-// Update history heuristic
-void update_history(const Board* board, Move move, int depth) {
-    Square from = move_from(move);
-    PieceType piece = PAWN;
-    for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
-        if (test_bit(board->pieces[board->side_to_move][pt], from)) {
-            piece = pt;
-            break;
+// Step an entry toward +-HISTORY_MAX by bonus, less the closer it already is
+static void apply_history(int16_t* entry, int bonus) {
+    *entry += bonus - *entry * abs(bonus) / HISTORY_MAX;
+}
+
+// A quiet move caused a beta cutoff at ply after the failed quiets were
+// searched in vain: it becomes a killer and the countermove to the move
+// before it, and its histories gain what theirs lose. Split point tasks
+// only read their owner's continuation history, so it is updated by the
+// thread that owns it alone.
+void update_quiet_stats(SearchThread* thread, int ply, Move move, int depth, const Move* failed, int failed_count) {
+    const Board* board = &thread->board;
+    int bonus = depth * depth * 32 < HISTORY_BONUS_MAX ? depth * depth * 32 : HISTORY_BONUS_MAX;
+
+    update_killers(thread, move, ply);
+    if (ply > 0 && move_not_equal(thread->stack[ply - 1].move, NULL_MOVE)) {
+        const SearchStack* previous = &thread->stack[ply - 1];
+        thread->countermoves[previous->piece][move_to(previous->move)] = move;
+    }
+
+    HistoryTable* history = &thread->history;
+    Color side = board->side_to_move;
+    apply_history(&(*history)[side][move_from(move)][move_to(move)], bonus);
+    for (int i = 0; i < failed_count; i++) {
+        apply_history(&(*history)[side][move_from(failed[i])][move_to(failed[i])], -bonus);
+    }
+
+    if (thread->split) return;
+    for (int c = 0; c < CONTINUATION_PLIES; c++) {
+        PieceToHistory* table = continuation_table(thread, ply, c);
+        if (!table) continue;
+        apply_history(&(*table)[board->piece_on[move_from(move)]][move_to(move)], bonus);
+        for (int i = 0; i < failed_count; i++) {
+            apply_history(&(*table)[board->piece_on[move_from(failed[i])]][move_to(failed[i])], -bonus);
         }
     }
-    
-    history_table[board->side_to_move][piece][from] += depth * depth;
+}
+
+// Remember a quiet move that caused a beta cutoff at this ply
+void update_killers(SearchThread* thread, Move move, int ply) {
+    Move* killers = thread->stack[ply].killers;
+    if (move_equal(move, killers[0])) return;
+    killers[1] = killers[0];
+    killers[0] = move;
 }
 
 // Time management
@@ -446,23 +1083,51 @@ void init_time_control(TimeControl* tc) {
     tc->infinite = 0;
 }
 
+long search_time_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+// Checked after each iteration. The next one takes several times as long as
+// everything so far, so none is started past half the soft limit. A fixed
+// movetime has no time to save for later moves, so iterations continue until
+// the hard limit aborts one.
 int should_stop_search(const TimeControl* tc) {
-    if (tc->infinite) return 0;
-    
-    // Simplified time management - always continue for now
+    if (tc->infinite || RELAXED_LOAD(&search_pondering)) return 0;
+
+    long elapsed = search_time_ms() - search_start_time;
+    if (search_soft_limit && tc->movetime <= 0 && elapsed * 2 >= search_soft_limit) return 1;
+    if (search_node_limit && total_nodes() >= search_node_limit) return 1;
     return 0;
 }
 
-int get_search_time(const TimeControl* tc) {
-    if (tc->movetime > 0) return tc->movetime;
-    
-    // Simplified time calculation
-    int time = tc->wtime; // Use white time as default
-    int inc = tc->winc;
-    
-    if (tc->movestogo > 0) {
-        return time / tc->movestogo + inc;
-    } else {
-        return time / 30 + inc; // Assume 30 moves remaining
+// Soft and hard limits in milliseconds for the side to move, 0 for none.
+// On a clock the soft limit is an even share of the remaining time plus most
+// of the increment; the hard limit allows a few times that when an
+// iteration runs long, but never more than three quarters of the clock.
+void get_search_time(const TimeControl* tc, Color side, int* soft, int* hard) {
+    *soft = 0;
+    *hard = 0;
+    if (tc->infinite) return;
+
+    if (tc->movetime > 0) {
+        int limit = tc->movetime - MOVE_OVERHEAD;
+        *soft = *hard = limit > 1 ? limit : 1;
+        return;
     }
-} 
\ No newline at end of file
+
+    int time = side == WHITE ? tc->wtime : tc->btime;
+    int inc = side == WHITE ? tc->winc : tc->binc;
+    if (time <= 0) return;  // No clock given: depth or node limited
+
+    int available = time - MOVE_OVERHEAD;
+    if (available < 1) available = 1;
+    int moves = tc->movestogo > 0 ? tc->movestogo : 30;  // Assume 30 moves remaining
+
+    int base = time / moves + inc * 3 / 4;
+    int cap = moves == 1 ? available : available * 3 / 4;
+    *hard = base * 4 < cap ? base * 4 : cap;
+    *soft = base < *hard ? base : *hard;
+    if (*hard < 1) *soft = *hard = 1;
+}
@@ -10,21 +10,105 @@
 #define MAX_DEPTH 64
 #define MAX_MOVES 256
 #define MATE_SCORE 10000
+#define MATE_BOUND (MATE_SCORE - MAX_DEPTH)  // Scores beyond this are mates, MATE_SCORE - plies to mate
 #define INFINITY 20000
+#define MAX_THREADS 64
 
 // Search parameters
-#define NULL_MOVE_R 3
+#define NULL_MOVE_R 3            // Base reduction of the null move search
+#define NULL_MOVE_MIN_DEPTH 3     // Shallower nodes do not try a null move
+#define NULL_MOVE_EVAL_STEP 200   // Extra ply of reduction per this much eval above beta, up to 3
+#define NULL_MOVE_VERIFY_DEPTH 12 // Null move cutoffs from this depth are verified
 #define FUTILITY_MARGIN 100
 #define RAZOR_MARGIN 300
+#define ASPIRATION_DEPTH 4      // Iterations from this depth start in a window around the last two scores
+#define ASPIRATION_WINDOW 25    // Margin beyond those scores, doubled on each failure
+
+// Time management
+#define MOVE_OVERHEAD 30        // Milliseconds kept back for communication lag
+#define TIME_CHECK_NODES 2048   // Nodes between clock checks, a power of two
 
 typedef struct {
     Move best_move;
     int score;
     int depth;
-    int nodes;
+    uint64_t nodes;
     int time_ms;
+    Move pv[MAX_DEPTH];  // Principal variation, starting with best_move
+    int pv_length;
 } SearchResult;
 
+// Quiet move statistics. Every entry moves toward a bonus or malus with
+// "gravity": the further it already is in that direction, the smaller the
+// step, so entries stay within +-HISTORY_MAX without clamping.
+#define HISTORY_MAX 16384
+#define HISTORY_BONUS_MAX 2048  // Largest step, reached at depth 8
+#define CONTINUATION_PLIES 2   // Earlier moves of the line that index continuation history
+
+// Butterfly history: [color][from square][to square]
+typedef int16_t HistoryTable[2][64][64];
+
+// History of a move given one earlier move: [piece][to square] of the move
+typedef int16_t PieceToHistory[6][64];
+
+// Continuation history: [piece][to square] of the earlier move
+typedef PieceToHistory ContinuationHistory[6][64];
+
+// Reply that refuted a move: [piece][to square] of that move
+typedef Move CountermoveTable[6][64];
+
+// Per-ply search state
+typedef struct {
+    Move killers[2];  // Two quiet moves that caused a beta cutoff at this ply
+    Move move;        // Move being searched from this ply; NULL_MOVE for a null move
+    int piece;        // PieceType of that move
+} SearchStack;
+
+// What the move picker needs to order a node's quiet moves
+typedef struct {
+    Move killers[2];
+    Move countermove;                  // Refutation of the previous move, if any
+    const HistoryTable* history;
+    const PieceToHistory* continuation[CONTINUATION_PLIES];  // For the moves 1 and 2 plies back, or NULL
+} QuietOrdering;
+
+// Best line found from one ply on. Each node builds its line from its best
+// move and the line of the child that move led to (a triangular PV table).
+typedef struct {
+    Move moves[MAX_DEPTH + 1];
+    int length;
+} PVLine;
+
+struct SplitPoint;
+
+// Everything one search thread writes. Lazy SMP threads share only the
+// transposition table; each searches its own copy of the root position
+// with its own move ordering state. In deterministic mode every split
+// point task also runs in a SearchThread of its own (see ybw.h).
+typedef struct {
+    Board board;
+    HistoryTable history;
+    CountermoveTable countermoves;
+    ContinuationHistory* continuation;  // Too large to copy per split point task; tasks read their owner's
+    SearchStack stack[MAX_DEPTH + 1];
+    SearchResult result;  // Last iteration this thread completed
+    int prior_score;      // Score of the iteration before that one
+    PVLine pv[MAX_DEPTH + 1];  // pv[ply]: line from the node being searched at ply
+    int follow_pv;        // Still on the path of result.pv, whose moves are tried first
+    int null_min_ply;     // While verifying a null move cutoff: no null moves for
+    Color null_color;     // null_color before this ply
+    int id;               // 0 is the main thread
+    struct SplitPoint* split;  // Deterministic mode: split point this context searches a move of
+#ifdef TT_VERIFY
+    int verifying;        // Nonzero while a table-less verification search runs
+#endif
+    // Incremented at every node; padded onto its own cache line so the
+    // counters of neighbouring threads never share one
+    char pad_before[64];
+    uint64_t nodes;
+    char pad_after[64 - sizeof(uint64_t)];
+} SearchThread;
+
 typedef struct {
     int wtime;
     int btime;
@@ -38,27 +122,32 @@ typedef struct {
 } TimeControl;
 
 // Main search functions
-SearchResult search_position(const Board* board, int depth);
+int search_set_threads(int count);
+void search_abort(void);
+void search_clear_abort(void);
+void search_set_ponder(int pondering);
+void search_set_deterministic(int enabled);
+void search_clear_history(void);
+SearchResult search_position(SearchThread* thread, int depth, int alpha, int beta);
+int search_move(SearchThread* thread, Move move, int depth, int ply, int alpha, int beta, int scout);
 SearchResult iterative_deepening(const Board* board, int max_depth, const TimeControl* tc);
-int alpha_beta_search(const Board* board, int depth, int alpha, int beta, int* nodes);
-int quiescence_search(const Board* board, int alpha, int beta, int* nodes);
+int alpha_beta_search(SearchThread* thread, int depth, int ply, int alpha, int beta);
+int quiescence_search(SearchThread* thread, int ply, int alpha, int beta);
 
 // Advanced search techniques
-int null_move_search(const Board* board, int depth, int alpha, int beta, int* nodes);
+int null_move_search(SearchThread* thread, int depth, int ply, int alpha, int beta);
 int futility_pruning(const Board* board, int depth, int alpha, int beta);
-int razor_pruning(const Board* board, int depth, int alpha, int beta);
+int razor_pruning(SearchThread* thread, int depth, int ply, int alpha, int beta);
 
 // Move ordering
-void order_moves(const Board* board, Move* moves, int count);
 int get_move_score(const Board* board, Move move);
-void update_history(const Board* board, Move move, int depth);
+void update_quiet_stats(SearchThread* thread, int ply, Move move, int depth, const Move* failed, int failed_count);
+void update_killers(SearchThread* thread, Move move, int ply);
 
 // Time management
 void init_time_control(TimeControl* tc);
+long search_time_ms(void);
 int should_stop_search(const TimeControl* tc);
-int get_search_time(const TimeControl* tc);
-
-// History heuristic
-extern int history_table[2][6][64];
+void get_search_time(const TimeControl* tc, Color side, int* soft, int* hard);
 
 #endif // SEARCH_H 
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "see.h"
+#include "bitboard.h"
+#include "evaluation.h"
+
+static const int see_values[PIECE_COUNT] = {
+    PAWN_VALUE, KNIGHT_VALUE, BISHOP_VALUE, ROOK_VALUE, QUEEN_VALUE, KING_VALUE
+};
+
+// Material the move itself wins before any recapture
+static int initial_gain(const Board* board, Move move) {
+    int gain = 0;
+    if (is_en_passant(move)) {
+        gain = PAWN_VALUE;
+    } else if (is_capture(move)) {
+        gain = see_values[board->piece_on[move_to(move)]];
+    }
+    if (is_promotion(move)) {
+        gain += see_values[promotion_piece(move)] - PAWN_VALUE;
+    }
+    return gain;
+}
+
+// Occupancy once the move has been made
+static Bitboard occupancy_after(const Board* board, Move move) {
+    Square from = move_from(move);
+    Square to = move_to(move);
+    Bitboard occupied = (board->occupied ^ square_bb[from]) | square_bb[to];
+    if (is_en_passant(move)) {
+        occupied ^= square_bb[board->side_to_move == WHITE ? to - 8 : to + 8];
+    }
+    return occupied;
+}
+
+// Least valuable attacker of 'color' in 'attackers'; NO_PIECE if there is none
+static PieceType least_valuable(const Board* board, Bitboard attackers, Color color, Square* sq) {
+    for (PieceType pt = PAWN; pt <= KING; pt++) {
+        Bitboard bb = attackers & board->pieces[color][pt];
+        if (bb) {
+            *sq = lsb(bb);
+            return pt;
+        }
+    }
+    return NO_PIECE;
+}
+
+// Sliders that see 'to' once the occupancy has changed
+static Bitboard slider_attackers(const Board* board, Square to, Bitboard occupied) {
+    Bitboard diagonal = board->pieces[WHITE][BISHOP] | board->pieces[BLACK][BISHOP] |
+                        board->pieces[WHITE][QUEEN] | board->pieces[BLACK][QUEEN];
+    Bitboard straight = board->pieces[WHITE][ROOK] | board->pieces[BLACK][ROOK] |
+                        board->pieces[WHITE][QUEEN] | board->pieces[BLACK][QUEEN];
+    return (bishop_attacks(to, occupied) & diagonal) | (rook_attacks(to, occupied) & straight);
+}
+
+int see(const Board* board, Move move) {
+    if (is_castle(move)) return 0;
+
+    Square to = move_to(move);
+    Color side = board->side_to_move;
+    Bitboard occupied = occupancy_after(board, move);
+    Bitboard attackers = board_attackers_to(board, to, occupied) & occupied;
+    int gain[32];
+    int depth = 0;
+
+    // Value of the piece standing on 'to' after each capture
+    PieceType on_square = is_promotion(move) ? promotion_piece(move) : (PieceType)board->piece_on[move_from(move)];
+    gain[0] = initial_gain(board, move);
+
+    for (;;) {
+        side = color_opposite(side);
+        Square sq = A1;
+        PieceType pt = least_valuable(board, attackers & board->by_color[side], side, &sq);
+        if (pt == NO_PIECE) break;
+
+        // A king may only recapture if the square is no longer defended
+        if (pt == KING && (attackers & board->by_color[color_opposite(side)])) break;
+
+        depth++;
+        gain[depth] = see_values[on_square] - gain[depth - 1];
+        on_square = pt;
+
+        occupied ^= square_bb[sq];
+        attackers = (attackers | slider_attackers(board, to, occupied)) & occupied;
+        if (depth == 31) break;
+    }
+
+    // Each side may decline to continue the exchange
+    while (depth > 0) {
+        if (-gain[depth] < gain[depth - 1]) gain[depth - 1] = -gain[depth];
+        depth--;
+    }
+    return gain[0];
+}
+
+int see_ge(const Board* board, Move move, int threshold) {
+    if (is_castle(move)) return 0 >= threshold;
+    if (is_promotion(move)) return see(board, move) >= threshold;
+
+    Square to = move_to(move);
+    Color side = board->side_to_move;
+
+    // Even if the moved piece is lost for nothing we are still above the threshold
+    int swap = initial_gain(board, move) - threshold;
+    if (swap < 0) return 0;
+    swap = see_values[board->piece_on[move_from(move)]] - swap;
+    if (swap <= 0) return 1;
+
+    Bitboard occupied = occupancy_after(board, move);
+    Bitboard attackers = board_attackers_to(board, to, occupied) & occupied;
+    int result = 1;
+
+    for (;;) {
+        side = color_opposite(side);
+        Bitboard side_attackers = attackers & board->by_color[side];
+        if (!side_attackers) break;
+
+        Square sq = A1;
+        PieceType pt = least_valuable(board, side_attackers, side, &sq);
+        result ^= 1;
+
+        // Capturing with the king only works if nothing recaptures
+        if (pt == KING) {
+            return (attackers & board->by_color[color_opposite(side)]) ? result ^ 1 : result;
+        }
+
+        swap = see_values[pt] - swap;
+        if (swap < result) break;
+
+        occupied ^= square_bb[sq];
+        attackers = (attackers | slider_attackers(board, to, occupied)) & occupied;
+    }
+    return result;
+}
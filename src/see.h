@@ -0,0 +1,17 @@
+#ifndef SEE_H
+#define SEE_H
+
+#include "board.h"
+#include "move.h"
+
+// Static exchange evaluation: material outcome of the capture sequence on
+// the move's destination, both sides always recapturing with their least
+// valuable attacker and allowed to stop when it stops paying. Sliders
+// hidden behind a capturing piece join in as it leaves (x-rays); pins are
+// ignored.
+int see(const Board* board, Move move);
+
+// Whether see(board, move) >= threshold, without building the whole swap list
+int see_ge(const Board* board, Move move, int threshold);
+
+#endif // SEE_H
@@ -1,113 +1,523 @@
+#define _DEFAULT_SOURCE  // MAP_ANONYMOUS, MAP_HUGETLB and madvise under -std=c99
 #include "transposition.h"
-#include <stddef.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TT_MMAP
+#if defined(__linux__) && !defined(TT_NO_LARGE_PAGES)
+#define TT_LARGE_PAGES
+#endif
+#endif
 
-static TTEntry tt_table[TT_SIZE];
-static uint8_t tt_age_counter = 0;
-
-// Zobrist keys for hashing
-static uint64_t zobrist_pieces[2][6][64];
-static uint64_t zobrist_side;
-static uint64_t zobrist_castling[16];
-static uint64_t zobrist_ep[64];
-
-// Initialize transposition table and Zobrist keys
-void tt_init(void) {
-    tt_clear();
-    
-    // Initialize Zobrist keys with simple hash values
-    uint64_t seed = 0x123456789ABCDEF0ULL;
-    for (Color c = WHITE; c < COLOR_COUNT; c++) {
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
-            for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
-                seed = seed * 1103515245ULL + 12345ULL;
-                zobrist_pieces[c][pt][sq] = seed;
-            }
+#define LARGE_PAGE_SIZE ((size_t)2 << 20)
+
+typedef enum {
+    TT_PAGES_NONE,
+    TT_PAGES_DEFAULT,      // malloc, aligned by hand to the cache line
+    TT_PAGES_TRANSPARENT,  // mmap aligned to 2 MB and madvise(MADV_HUGEPAGE)
+    TT_PAGES_HUGETLB,      // mmap(MAP_HUGETLB) from the reserved huge page pool
+    TT_PAGES_FILE,         // Private mapping of a saved table (tt_load)
+    TT_PAGES_ANONYMOUS     // Plain mmap, small pages zeroed as they are first touched
+} TTPages;
+
+// Buckets live in one block aligned to at least the cache line, so a probe
+// touches a single line. At hundreds of megabytes most probes also miss the
+// TLB, so on Linux the block is backed by 2 MB pages where the system allows.
+TTBucket* tt_table = NULL;
+size_t tt_bucket_count = 0;
+
+// Entries carry the generation they were written in. tt_age starts a new
+// one per search; tt_clear also moves tt_clear_generation forward, and
+// anything older than that is treated as empty. Generations wrap after 64,
+// so the memory is wiped once before a value could be reused.
+static uint8_t tt_generation = 0;
+static uint8_t tt_clear_generation = 0;
+static int tt_generations_used = 0;
+
+#define GENBOUND(gen, flag) ((uint8_t)((gen) << 2 | (flag)))
+#define ENTRY_FLAG(e) ((TTFlag)((e)->genbound & 3))
+#define ENTRY_GEN(e) ((e)->genbound >> 2)
+
+// Relaxed atomics are enough: an entry is self-contained and only its
+// own word has to be consistent
+#if defined(__GNUC__)
+#define SLOT_LOAD(slot) __atomic_load_n(slot, __ATOMIC_RELAXED)
+#define SLOT_STORE(slot, word) __atomic_store_n(slot, word, __ATOMIC_RELAXED)
+#define SLOT_REPLACE(slot, expected, word) \
+    __atomic_compare_exchange_n(slot, &(expected), word, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED)
+#else
+#define SLOT_LOAD(slot) (*(volatile uint64_t*)(slot))
+#define SLOT_STORE(slot, word) (*(volatile uint64_t*)(slot) = (word))
+#define SLOT_REPLACE(slot, expected, word) (SLOT_STORE(slot, word), 1)
+#endif
+
+static inline TTEntry unpack(uint64_t word) {
+    TTEntry entry;
+    memcpy(&entry, &word, sizeof(entry));
+    return entry;
+}
+
+static inline uint64_t pack(const TTEntry* entry) {
+    uint64_t word;
+    memcpy(&word, entry, sizeof(word));
+    return word;
+}
+
+// Searches since the entry was written
+static inline int entry_age(const TTEntry* entry) {
+    return (tt_generation - ENTRY_GEN(entry)) & (TT_GENERATIONS - 1);
+}
+
+static inline int entry_valid(const TTEntry* entry) {
+    return ENTRY_FLAG(entry) != TT_NONE &&
+           entry_age(entry) <= ((tt_generation - tt_clear_generation) & (TT_GENERATIONS - 1));
+}
+
+static void wipe(void) {
+    memset(tt_table, 0, tt_bucket_count * sizeof(TTBucket));
+    tt_generations_used = 0;
+    tt_clear_generation = tt_generation;
+}
+
+static void next_generation(void) {
+    tt_generation = (tt_generation + 1) & (TT_GENERATIONS - 1);
+    if (++tt_generations_used == TT_GENERATIONS) wipe();
+}
+
+// A block of memory holding the bucket array; how it was obtained decides how it is freed
+typedef struct {
+    void* base;
+    size_t size;
+    TTPages pages;
+} TTMemory;
+
+static TTMemory tt_memory = { NULL, 0, TT_PAGES_NONE };
+
+// Deterministic search must not see entries stored during the current
+// iteration, since which ones exist would depend on thread timing. While
+// tt_deferring is set, stores go to a staging table with the same buckets
+// and reach the real table only at tt_commit. Each slot filled is also
+// listed, so the commit visits only those rather than the whole table.
+static TTBucket* tt_staging = NULL;
+static TTMemory tt_staging_memory = { NULL, 0, TT_PAGES_NONE };
+static int tt_deferring = 0;
+static uint64_t* tt_dirty = NULL;     // Indices of filled staging slots, in no particular order
+static size_t tt_dirty_capacity = 0;
+static size_t tt_dirty_count = 0;     // May pass the capacity; the commit then scans every bucket
+
+#define TT_DIRTY_MAX ((size_t)1 << 20)  // Listed slots per iteration, 8 MB
+
+static void free_memory(TTMemory* memory) {
+#ifdef TT_MMAP
+    if (memory->pages != TT_PAGES_DEFAULT && memory->pages != TT_PAGES_NONE) {
+        munmap(memory->base, memory->size);
+    } else
+#endif
+    free(memory->base);
+    memory->base = NULL;
+    memory->pages = TT_PAGES_NONE;
+}
+
+static void free_staging(void) {
+    if (tt_staging) free_memory(&tt_staging_memory);
+    tt_staging = NULL;
+    free(tt_dirty);
+    tt_dirty = NULL;
+    tt_dirty_capacity = 0;
+    tt_dirty_count = 0;
+    tt_deferring = 0;
+}
+
+// Try the huge page pool first, then transparent huge pages, then plain malloc
+static TTBucket* allocate_table(size_t size, TTMemory* memory) {
+#ifdef TT_LARGE_PAGES
+    if (size >= LARGE_PAGE_SIZE) {
+        size_t rounded = (size + LARGE_PAGE_SIZE - 1) & ~(LARGE_PAGE_SIZE - 1);
+        void* base = mmap(NULL, rounded, PROT_READ | PROT_WRITE,
+                          MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (base != MAP_FAILED) {
+            memory->base = base;
+            memory->size = rounded;
+            memory->pages = TT_PAGES_HUGETLB;
+            return (TTBucket*)base;
+        }
+
+        // Over-allocate so the table can start on a 2 MB boundary
+        base = mmap(NULL, size + LARGE_PAGE_SIZE, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (base != MAP_FAILED) {
+            uintptr_t aligned = ((uintptr_t)base + LARGE_PAGE_SIZE - 1) & ~(uintptr_t)(LARGE_PAGE_SIZE - 1);
+            madvise((void*)aligned, size, MADV_HUGEPAGE);
+            memory->base = base;
+            memory->size = size + LARGE_PAGE_SIZE;
+            memory->pages = TT_PAGES_TRANSPARENT;
+            return (TTBucket*)aligned;
         }
     }
-    
-    seed = seed * 1103515245ULL + 12345ULL;
-    zobrist_side = seed;
-    
-    for (int i = 0; i < 16; i++) {
-        seed = seed * 1103515245ULL + 12345ULL;
-        zobrist_castling[i] = seed;
+#endif
+    void* base = malloc(size + 63);
+    if (!base) return NULL;
+    memory->base = base;
+    memory->size = size + 63;
+    memory->pages = TT_PAGES_DEFAULT;
+    return (TTBucket*)(((uintptr_t)base + 63) & ~(uintptr_t)63);
+}
+
+// Zeroed memory for the staging table. It is touched only where entries
+// are staged, so small pages filled in on demand are far cheaper than
+// clearing it up front or faulting in a 2 MB page for each scattered store.
+static TTBucket* allocate_zeroed(size_t size, TTMemory* memory) {
+#ifdef TT_MMAP
+    void* mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapped != MAP_FAILED) {
+#ifdef TT_LARGE_PAGES
+        madvise(mapped, size, MADV_NOHUGEPAGE);
+#endif
+        memory->base = mapped;
+        memory->size = size;
+        memory->pages = TT_PAGES_ANONYMOUS;
+        return (TTBucket*)mapped;
     }
-    
-    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
-        seed = seed * 1103515245ULL + 12345ULL;
-        zobrist_ep[sq] = seed;
+#endif
+    void* base = calloc(1, size + 63);
+    if (!base) return NULL;
+    memory->base = base;
+    memory->size = size + 63;
+    memory->pages = TT_PAGES_DEFAULT;
+    return (TTBucket*)(((uintptr_t)base + 63) & ~(uintptr_t)63);
+}
+
+// Allocate a table of (at most) mb megabytes; the old table is kept if allocation fails
+int tt_resize(size_t mb) {
+    size_t count = (mb << 20) / sizeof(TTBucket);
+    if (count == 0) count = 1;
+    if (count > ((size_t)1 << 32)) count = (size_t)1 << 32;
+
+    TTMemory memory;
+    TTBucket* table = allocate_table(count * sizeof(TTBucket), &memory);
+    if (!table) return -1;
+
+    free_staging();
+    free_memory(&tt_memory);
+    tt_memory = memory;
+    tt_table = table;
+    tt_bucket_count = count;
+    wipe();
+    return 0;
+}
+
+const char* tt_page_string(void) {
+    switch (tt_memory.pages) {
+        case TT_PAGES_HUGETLB:     return "hugetlb";
+        case TT_PAGES_TRANSPARENT: return "transparent";
+        case TT_PAGES_DEFAULT:     return "default";
+        case TT_PAGES_FILE:        return "file";
+        case TT_PAGES_ANONYMOUS:
+        case TT_PAGES_NONE:        break;
     }
+    return "none";
+}
+
+size_t tt_size_mb(void) {
+    return (tt_bucket_count * sizeof(TTBucket)) >> 20;
 }
 
+// Start a new generation that everything stored so far is older than
 void tt_clear(void) {
-    for (int i = 0; i < TT_SIZE; i++) {
-        tt_table[i].key = 0;
-        tt_table[i].best_move = NULL_MOVE;
-        tt_table[i].score = 0;
-        tt_table[i].depth = 0;
-        tt_table[i].flag = TT_EXACT;
-        tt_table[i].age = 0;
+    next_generation();
+    tt_clear_generation = tt_generation;
+}
+
+static void store_entry(TTBucket* bucket, uint16_t check, Move best_move, int score, int depth, TTFlag flag) {
+    uint64_t* replace = NULL;
+    int replace_value = INT_MAX;
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        TTEntry entry = unpack(SLOT_LOAD(&bucket->slots[i]));
+        int valid = entry_valid(&entry);
+        if (valid && entry.key == check) {
+            // Keep a deeper bound from this search unless the new result is exact
+            if (flag != TT_EXACT && depth < entry.depth && entry_age(&entry) == 0) {
+                if (move_not_equal(best_move, NULL_MOVE) && move_not_equal(best_move, entry.best_move)) {
+                    entry.best_move = best_move;
+                    SLOT_STORE(&bucket->slots[i], pack(&entry));
+                }
+                return;
+            }
+            if (move_equal(best_move, NULL_MOVE)) best_move = entry.best_move;
+            replace = &bucket->slots[i];
+            break;
+        }
+
+        // Otherwise fill an empty slot, or evict the shallowest entry
+        // counting each search of age as 8 plies
+        int value = valid ? entry.depth - 8 * entry_age(&entry) : INT_MIN;
+        if (value < replace_value) {
+            replace_value = value;
+            replace = &bucket->slots[i];
+        }
+    }
+
+    TTEntry entry;
+    entry.key = check;
+    entry.best_move = best_move;
+    entry.score = (int16_t)score;
+    entry.depth = (uint8_t)depth;
+    entry.genbound = GENBOUND(tt_generation, flag);
+    SLOT_STORE(replace, pack(&entry));
+}
+
+// Keep whichever of two staged words ranks higher: deeper first, then by
+// bound type, then by the raw word, so the winner never depends on the
+// order the stores arrived in
+static inline int staged_better(uint64_t word, uint64_t than) {
+    TTEntry a = unpack(word), b = unpack(than);
+    int rank_a = a.depth << 2 | ENTRY_FLAG(&a), rank_b = b.depth << 2 | ENTRY_FLAG(&b);
+    return rank_a != rank_b ? rank_a > rank_b : word > than;
+}
+
+static void stage_entry(uint64_t key, Move best_move, int score, int depth, TTFlag flag) {
+    TTEntry entry;
+    entry.key = (uint16_t)(key >> 48);
+    entry.best_move = best_move;
+    entry.score = (int16_t)score;
+    entry.depth = (uint8_t)depth;
+    entry.genbound = GENBOUND(tt_generation, flag);
+    uint64_t word = pack(&entry);
+
+    // Same bucket as in the table, and a slot picked by key bits neither the
+    // bucket index nor the check uses
+    uint64_t* slot = &tt_staging[tt_bucket(key) - tt_table].slots[(key >> 32) & (TT_BUCKET_ENTRIES - 1)];
+    uint64_t current = SLOT_LOAD(slot);
+    while (staged_better(word, current)) {
+        if (SLOT_REPLACE(slot, current, word)) {
+            // Exactly one store finds the slot empty, and that one lists it
+            if (current == 0) {
+                size_t n = __atomic_fetch_add(&tt_dirty_count, 1, __ATOMIC_RELAXED);
+                if (n < tt_dirty_capacity) tt_dirty[n] = (uint64_t)(slot - &tt_staging[0].slots[0]);
+            }
+            break;
+        }
     }
 }
 
 void tt_store(uint64_t key, Move best_move, int score, int depth, TTFlag flag) {
-    uint32_t index = key & TT_MASK;
-    TTEntry* entry = &tt_table[index];
-    
-    // Replace if entry is empty, older, or shallower
-    if (entry->key == 0 || entry->age < tt_age_counter || entry->depth <= depth) {
-        entry->key = key;
-        entry->best_move = best_move;
-        entry->score = score;
-        entry->depth = depth;
-        entry->flag = flag;
-        entry->age = tt_age_counter;
+    if (!tt_table) return;
+    if (tt_deferring) {
+        stage_entry(key, best_move, score, depth, flag);
+        return;
     }
+    store_entry(tt_bucket(key), (uint16_t)(key >> 48), best_move, score, depth, flag);
 }
 
-TTEntry* tt_probe(uint64_t key) {
-    uint32_t index = key & TT_MASK;
-    TTEntry* entry = &tt_table[index];
-    
-    if (entry->key == key) {
-        return entry;
+int tt_set_deferred(int enabled) {
+    if (enabled && !tt_staging) {
+        size_t slots = tt_bucket_count * TT_BUCKET_ENTRIES;
+        size_t capacity = slots < TT_DIRTY_MAX ? slots : TT_DIRTY_MAX;
+        uint64_t* dirty = malloc(capacity * sizeof(uint64_t));
+        if (!dirty) return -1;
+        TTBucket* staging = allocate_zeroed(tt_bucket_count * sizeof(TTBucket), &tt_staging_memory);
+        if (!staging) {
+            free(dirty);
+            return -1;
+        }
+        tt_staging = staging;
+        tt_dirty = dirty;
+        tt_dirty_capacity = capacity;
+        tt_dirty_count = 0;
     }
-    
-    return NULL;
+    tt_deferring = enabled;
+    return 0;
 }
 
-void tt_age(void) {
-    tt_age_counter++;
-}
-
-// Generate Zobrist hash for a position
-uint64_t generate_hash(const Board* board) {
-    uint64_t hash = 0;
-    
-    // Hash pieces
-    for (Color c = WHITE; c < COLOR_COUNT; c++) {
-        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
-            Bitboard pieces = board->pieces[c][pt];
-            while (pieces) {
-                Square sq = pop_lsb(&pieces);
-                hash ^= zobrist_pieces[c][pt][sq];
+static void commit_slot(uint64_t index) {
+    uint64_t* slot = &tt_staging[0].slots[0] + index;
+    TTEntry entry = unpack(*slot);
+    store_entry(&tt_table[index / TT_BUCKET_ENTRIES], entry.key, entry.best_move, entry.score, entry.depth,
+                ENTRY_FLAG(&entry));
+    *slot = 0;
+}
+
+static int compare_index(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+// Single-threaded: moves staged entries into the table in slot order, so
+// the result does not depend on the order the stores were listed in
+void tt_commit(void) {
+    if (!tt_staging) return;
+    if (tt_dirty_count <= tt_dirty_capacity) {
+        qsort(tt_dirty, tt_dirty_count, sizeof(uint64_t), compare_index);
+        for (size_t i = 0; i < tt_dirty_count; i++) commit_slot(tt_dirty[i]);
+    } else {
+        // Too many to list: scan every slot instead
+        const uint64_t* slots = &tt_staging[0].slots[0];
+        for (uint64_t i = 0; i < (uint64_t)tt_bucket_count * TT_BUCKET_ENTRIES; i++) {
+            if (slots[i]) commit_slot(i);
+        }
+    }
+    tt_dirty_count = 0;
+}
+
+int tt_probe(uint64_t key, TTData* data) {
+    if (!tt_table) return 0;
+
+    TTBucket* bucket = tt_bucket(key);
+    uint16_t check = (uint16_t)(key >> 48);
+
+    for (int i = 0; i < TT_BUCKET_ENTRIES; i++) {
+        uint64_t word = SLOT_LOAD(&bucket->slots[i]);
+        TTEntry entry = unpack(word);
+        if (entry.key == check && entry_valid(&entry)) {
+            // A hit keeps the entry current for replacement, unless another
+            // thread has rewritten the slot in the meantime
+            if (ENTRY_GEN(&entry) != tt_generation) {
+                TTEntry refreshed = entry;
+                refreshed.genbound = GENBOUND(tt_generation, ENTRY_FLAG(&entry));
+                SLOT_REPLACE(&bucket->slots[i], word, pack(&refreshed));
             }
+            data->best_move = entry.best_move;
+            data->score = entry.score;
+            data->depth = entry.depth;
+            data->flag = ENTRY_FLAG(&entry);
+            return 1;
         }
     }
-    
-    // Hash side to move
-    if (board->side_to_move == BLACK) {
-        hash ^= zobrist_side;
-    }
-    
-    // Hash castling rights
-    hash ^= zobrist_castling[board->castling_rights];
-    
-    // Hash en passant square
-    if (board->en_passant != A1) {
-        hash ^= zobrist_ep[board->en_passant];
-    }
-    
-    return hash;
-} 
\ No newline at end of file
+    return 0;
+}
+
+void tt_age(void) {
+    next_generation();
+}
+
+// Saved tables start with this header, padded to a cache line so the
+// buckets that follow stay aligned when the file is mapped
+#define TT_FILE_MAGIC "RYSKATT"
+#define TT_FILE_VERSION 1
+
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t bucket_size;      // sizeof(TTBucket), catches entry layout changes
+    uint64_t zobrist_seed;     // Keys from another seed would match the wrong positions
+    uint64_t bucket_count;
+    uint8_t generation;        // Generation state, so entries keep their age and validity
+    uint8_t clear_generation;
+    uint8_t generations_used;
+    uint8_t reserved[29];
+} TTFileHeader;
+
+// Write the header and the bucket array to path
+TTFileResult tt_save(const char* path) {
+    if (!tt_table) return TT_FILE_IO_ERROR;
+
+    TTFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC));
+    header.version = TT_FILE_VERSION;
+    header.bucket_size = sizeof(TTBucket);
+    header.zobrist_seed = ZOBRIST_SEED;
+    header.bucket_count = tt_bucket_count;
+    header.generation = tt_generation;
+    header.clear_generation = tt_clear_generation;
+    header.generations_used = (uint8_t)tt_generations_used;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) return TT_FILE_IO_ERROR;
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+             fwrite(tt_table, sizeof(TTBucket), tt_bucket_count, file) == tt_bucket_count;
+    if (fclose(file) != 0) ok = 0;
+    return ok ? TT_FILE_OK : TT_FILE_IO_ERROR;
+}
+
+static TTFileResult check_header(const TTFileHeader* header, uint64_t file_size) {
+    if (memcmp(header->magic, TT_FILE_MAGIC, sizeof(TT_FILE_MAGIC)) != 0 ||
+        header->version != TT_FILE_VERSION || header->bucket_size != sizeof(TTBucket) ||
+        header->bucket_count == 0 || header->bucket_count > ((uint64_t)1 << 32) ||
+        file_size != sizeof(TTFileHeader) + header->bucket_count * sizeof(TTBucket)) {
+        return TT_FILE_BAD_FORMAT;
+    }
+    if (header->zobrist_seed != ZOBRIST_SEED) return TT_FILE_KEY_MISMATCH;
+    return TT_FILE_OK;
+}
+
+static void adopt_table(const TTFileHeader* header, TTBucket* table, TTMemory* memory) {
+    free_staging();
+    free_memory(&tt_memory);
+    tt_memory = *memory;
+    tt_table = table;
+    tt_bucket_count = (size_t)header->bucket_count;
+    tt_generation = header->generation & (TT_GENERATIONS - 1);
+    tt_clear_generation = header->clear_generation & (TT_GENERATIONS - 1);
+    tt_generations_used = header->generations_used;
+}
+
+// Replace the table with one saved by tt_save. The file is mapped
+// copy-on-write, so loading is immediate and pages are read as probes reach
+// them; the file itself is never modified. The table takes the file's size.
+TTFileResult tt_load(const char* path) {
+#ifdef TT_MMAP
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return TT_FILE_IO_ERROR;
+
+    struct stat st;
+    TTFileHeader header;
+    if (fstat(fd, &st) != 0 || read(fd, &header, sizeof(header)) != (ssize_t)sizeof(header)) {
+        close(fd);
+        return TT_FILE_IO_ERROR;
+    }
+    TTFileResult result = check_header(&header, (uint64_t)st.st_size);
+    if (result != TT_FILE_OK) {
+        close(fd);
+        return result;
+    }
+
+    void* base = mmap(NULL, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return TT_FILE_IO_ERROR;
+    madvise(base, (size_t)st.st_size, MADV_WILLNEED);
+
+    TTMemory memory = { base, (size_t)st.st_size, TT_PAGES_FILE };
+    adopt_table(&header, (TTBucket*)((char*)base + sizeof(TTFileHeader)), &memory);
+    return TT_FILE_OK;
+#else
+    // Without mmap the buckets are read into a fresh allocation
+    FILE* file = fopen(path, "rb");
+    if (!file) return TT_FILE_IO_ERROR;
+
+    TTFileHeader header;
+    long file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) file_size = ftell(file);
+    if (file_size < 0 || fseek(file, 0, SEEK_SET) != 0 || fread(&header, sizeof(header), 1, file) != 1) {
+        fclose(file);
+        return TT_FILE_IO_ERROR;
+    }
+    TTFileResult result = check_header(&header, (uint64_t)file_size);
+    if (result != TT_FILE_OK) {
+        fclose(file);
+        return result;
+    }
+
+    TTMemory memory;
+    TTBucket* table = allocate_table((size_t)header.bucket_count * sizeof(TTBucket), &memory);
+    if (!table) {
+        fclose(file);
+        return TT_FILE_IO_ERROR;
+    }
+    if (fread(table, sizeof(TTBucket), (size_t)header.bucket_count, file) != header.bucket_count) {
+        fclose(file);
+        free_memory(&memory);
+        return TT_FILE_IO_ERROR;
+    }
+    fclose(file);
+    adopt_table(&header, table, &memory);
+    return TT_FILE_OK;
+#endif
+}
@@ -1,33 +1,84 @@
 #ifndef TRANSPOSITION_H
 #define TRANSPOSITION_H
 
+#include <stddef.h>
 #include "constants.h"
 #include "board.h"
 #include "move.h"
+#include "zobrist.h"
 
-#define TT_SIZE (1 << 20)  // 1M entries
-#define TT_MASK (TT_SIZE - 1)
+#define TT_DEFAULT_MB 32
+#define TT_BUCKET_ENTRIES 8   // 8-byte entries, one 64-byte cache line per bucket
+#define TT_GENERATIONS 64     // Generation is 6 bits of genbound
 
 typedef enum {
-    TT_EXACT = 0,
-    TT_ALPHA = 1,
-    TT_BETA = 2
+    TT_NONE = 0,   // Empty slot
+    TT_ALPHA = 1,  // Upper bound: every move failed low
+    TT_BETA = 2,   // Lower bound: a move failed high
+    TT_EXACT = 3
 } TTFlag;
 
+// Packed table entry. Only the upper 16 bits of the key are kept; the
+// bucket index supplies the lower ones.
+typedef struct {
+    uint16_t key;
+    Move best_move;
+    int16_t score;
+    uint8_t depth;
+    uint8_t genbound;  // Generation << 2 | TTFlag
+} TTEntry;
+
+// Search threads share the table without locks: each entry is read and
+// written as one 64-bit word, so a probe sees either the old or the new
+// entry, never a mix of two
+typedef struct {
+    uint64_t slots[TT_BUCKET_ENTRIES];
+} TTBucket;
+
+// Outcome of tt_save and tt_load
+typedef enum {
+    TT_FILE_OK = 0,
+    TT_FILE_IO_ERROR,       // Could not open, read, write or map the file
+    TT_FILE_BAD_FORMAT,     // Not a saved table, or from another format version
+    TT_FILE_KEY_MISMATCH    // Saved by a build with a different ZOBRIST_SEED
+} TTFileResult;
+
+// Unpacked copy of an entry returned by tt_probe
 typedef struct {
-    uint64_t key;
     Move best_move;
     int score;
     int depth;
     TTFlag flag;
-    uint8_t age;
-} TTEntry;
+} TTData;
+
+// Bucket array, exposed so tt_prefetch can be inlined into board_make_move
+extern TTBucket* tt_table;
+extern size_t tt_bucket_count;
+
+// The low 32 key bits pick the bucket, scaled to any bucket count; the top 16 are the check
+static inline TTBucket* tt_bucket(uint64_t key) {
+    return &tt_table[((uint64_t)(uint32_t)key * tt_bucket_count) >> 32];
+}
+
+// Start loading a bucket that is about to be probed (only in TT_PREFETCH builds)
+static inline void tt_prefetch(uint64_t key) {
+#if defined(__GNUC__) && defined(TT_PREFETCH)
+    __builtin_prefetch(tt_bucket(key));
+#else
+    (void)key;
+#endif
+}
 
-void tt_init(void);
+int tt_resize(size_t mb);
+const char* tt_page_string(void);
+size_t tt_size_mb(void);
 void tt_clear(void);
 void tt_store(uint64_t key, Move best_move, int score, int depth, TTFlag flag);
-TTEntry* tt_probe(uint64_t key);
+int tt_probe(uint64_t key, TTData* data);
 void tt_age(void);
-uint64_t generate_hash(const Board* board);
+int tt_set_deferred(int enabled);
+void tt_commit(void);
+TTFileResult tt_save(const char* path);
+TTFileResult tt_load(const char* path);
 
-#endif // TRANSPOSITION_H 
\ No newline at end of file
+#endif // TRANSPOSITION_H
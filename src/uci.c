@@ -1,22 +1,57 @@
+#define _POSIX_C_SOURCE 200809L  // strncasecmp and pthreads under -std=c99
+
 #include "uci.h"
 #include "bitboard.h"
+#include "cpu.h"
 #include "evaluation.h"
 #include "movegen.h"
 #include "search.h"
 #include "book.h"
+#include "perft.h"
 #include <stdio.h>
 #include <string.h>
 #include <strings.h>
 #include <stdlib.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "board.h"
 
 // Global board state
 static Board current_board;
 static int engine_ready = 0;
-static int stop_search = 0;
 static char last_moves_string[512] = "";
 
+// Commands are read by an input thread and queued for the UCI loop, and each
+// go runs on a search thread of its own, so the loop is free during a search
+#define COMMAND_LENGTH 1024
+#define COMMAND_QUEUE_SIZE 16  // Initial capacity; the queue grows as needed
+
+// The queue never blocks the input thread, which must stay free to read stop
+// and quit however many commands are waiting behind a search
+static char (*command_queue)[COMMAND_LENGTH] = NULL;
+static int queue_capacity = 0;
+static int queue_head = 0;
+static int queue_count = 0;
+static pthread_mutex_t queue_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t queue_not_empty = PTHREAD_COND_INITIALIZER;
+
+// A go command's search, run on search_thread. search_running stays set
+// until bestmove has been printed; it and stop_search are guarded by search_lock.
+typedef struct {
+    Board board;
+    int depth;
+    TimeControl tc;
+} SearchJob;
+
+static SearchJob search_job;
+static pthread_t search_thread;
+static int search_thread_joinable = 0;
+static int search_running = 0;
+static int search_pondering = 0;  // go ponder, until ponderhit
+static int stop_search = 0;
+static pthread_mutex_t search_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t search_stopped = PTHREAD_COND_INITIALIZER;
+
 // Helper: find the exact legal Move object matching from/to (and promotion piece)
 static Move find_matching_legal(const Board* board, Square from, Square to, int has_promo, PieceType promo_piece) {
     Move legal_moves[256];
@@ -37,8 +72,10 @@ static Move find_matching_legal(const Board* board, Square from, Square to, int
 }
 
 // Dummy options
-static int hash_size_mb = 32;
+static int hash_size_mb = TT_DEFAULT_MB;
 static int own_book = 1;
+static int thread_count = 1;
+static char hash_file[256] = "hash.bin";
 
 // Forward declaration for uci_setoption
 void uci_setoption(const char* command);
@@ -75,13 +112,134 @@ const char* get_book_move(const char* moves) {
     return NULL;
 }
 
-// Main UCI loop
-void uci_loop(void) {
-    char command[1024];
-    
+// Double the ring, moving the waiting commands to the front of the new one
+static int queue_grow(void) {
+    int capacity = queue_capacity ? queue_capacity * 2 : COMMAND_QUEUE_SIZE;
+    char (*grown)[COMMAND_LENGTH] = malloc((size_t)capacity * COMMAND_LENGTH);
+    if (!grown) return -1;
+    for (int i = 0; i < queue_count; i++) {
+        memcpy(grown[i], command_queue[(queue_head + i) % queue_capacity], COMMAND_LENGTH);
+    }
+    free(command_queue);
+    command_queue = grown;
+    queue_capacity = capacity;
+    queue_head = 0;
+    return 0;
+}
+
+static void queue_push(const char* command) {
+    pthread_mutex_lock(&queue_lock);
+    if (queue_count == queue_capacity && queue_grow() != 0) {
+        pthread_mutex_unlock(&queue_lock);
+        fprintf(stderr, "cannot queue command: %s\n", command);
+        return;
+    }
+    char* slot = command_queue[(queue_head + queue_count) % queue_capacity];
+    strncpy(slot, command, COMMAND_LENGTH - 1);
+    slot[COMMAND_LENGTH - 1] = 0;
+    queue_count++;
+    pthread_cond_signal(&queue_not_empty);
+    pthread_mutex_unlock(&queue_lock);
+}
+
+static void queue_pop(char* command) {
+    pthread_mutex_lock(&queue_lock);
+    while (queue_count == 0) {
+        pthread_cond_wait(&queue_not_empty, &queue_lock);
+    }
+    strcpy(command, command_queue[queue_head]);
+    queue_head = (queue_head + 1) % queue_capacity;
+    queue_count--;
+    pthread_mutex_unlock(&queue_lock);
+}
+
+// End the running search, if any. Safe from any thread.
+static void interrupt_search(void) {
+    pthread_mutex_lock(&search_lock);
+    if (search_running) {
+        search_abort();
+        stop_search = 1;
+        pthread_cond_broadcast(&search_stopped);
+    }
+    pthread_mutex_unlock(&search_lock);
+}
+
+// The opponent played the expected move: the ponder search becomes a normal
+// timed search without restarting. Safe from any thread.
+static void ponderhit_search(void) {
+    pthread_mutex_lock(&search_lock);
+    if (search_running && search_pondering) {
+        search_pondering = 0;
+        search_set_ponder(0);
+        pthread_cond_broadcast(&search_stopped);
+    }
+    pthread_mutex_unlock(&search_lock);
+}
+
+// Block until the last search has printed its bestmove
+static void wait_for_search(void) {
+    if (search_thread_joinable) {
+        pthread_join(search_thread, NULL);
+        search_thread_joinable = 0;
+    }
+}
+
+// stop, quit and ponderhit reach a running search as soon as they are read,
+// and isready is answered at once during a search, even while the UCI loop is
+// blocked on an earlier command. Everything else goes through the queue in order.
+static void* input_main(void* arg) {
+    (void)arg;
+    char command[COMMAND_LENGTH];
     while (fgets(command, sizeof(command), stdin)) {
         command[strcspn(command, "\n")] = 0;
         trim(command);
+
+        if (strncmp(command, "stop", 4) == 0 || strncmp(command, "quit", 4) == 0) {
+            interrupt_search();
+        } else if (strncmp(command, "ponderhit", 9) == 0) {
+            ponderhit_search();
+            continue;
+        } else if (strncmp(command, "isready", 7) == 0) {
+            pthread_mutex_lock(&search_lock);
+            int answered = search_running;
+            if (answered) {
+                printf("readyok\n");
+                fflush(stdout);
+            }
+            pthread_mutex_unlock(&search_lock);
+            if (answered) continue;
+        }
+        queue_push(command);
+    }
+    queue_push("quit");
+    return NULL;
+}
+
+// Main UCI loop
+void uci_loop(void) {
+    char command[COMMAND_LENGTH];
+    
+    // Kernel selection is the only startup work, so every command is valid
+    // before isready
+    init_bitboards();
+    board_init(&current_board);
+    tt_resize(hash_size_mb);
+    
+    pthread_t input_thread;
+    if (pthread_create(&input_thread, NULL, input_main, NULL) != 0) {
+        fprintf(stderr, "cannot start input thread\n");
+        return;
+    }
+    
+    for (;;) {
+        queue_pop(command);
+        
+        // Only isready and ponderhit may be handled while a search runs;
+        // every other command waits for its bestmove
+        if (strncmp(command, "isready", 7) != 0 && strncmp(command, "ponderhit", 9) != 0) {
+            if (strncmp(command, "stop", 4) == 0) interrupt_search();
+            wait_for_search();
+        }
         
         if (strncmp(command, "ucinewgame", 10) == 0) {
             uci_newgame();
@@ -91,8 +249,13 @@ void uci_loop(void) {
             uci_uci();
         } else if (strncmp(command, "position", 8) == 0) {
             uci_position(command);
+        } else if (strncmp(command, "savehash", 8) == 0) {
+            uci_savehash();
+        } else if (strncmp(command, "loadhash", 8) == 0) {
+            uci_loadhash();
+        } else if (strncmp(command, "perft", 5) == 0) {
+            uci_perft(command + 5);
         } else if (strncmp(command, "go", 2) == 0) {
-            stop_search = 0;
             uci_go(command);
         } else if (strncmp(command, "eval", 4) == 0) {
             int cp = evaluate_position(&current_board);
@@ -101,16 +264,15 @@ void uci_loop(void) {
             printf("info string eval %+.2f\n", dec);
             fflush(stdout);
         } else if (strncmp(command, "stop", 4) == 0) {
-            stop_search = 1;
             uci_stop();
         } else if (strncmp(command, "quit", 4) == 0) {
             uci_quit();
+        } else if (strncmp(command, "ponderhit", 9) == 0) {
+            ponderhit_search();
         } else if (strncmp(command, "setoption", 9) == 0) {
             uci_setoption(command);
         } else if (strncmp(command, "register", 8) == 0) {
             printf("registration ok\n");
-        } else if (strncmp(command, "ponderhit", 9) == 0) {
-            // Not implemented, just acknowledge
         } else {
             // Ignore unknown commands
         }
@@ -121,8 +283,11 @@ void uci_loop(void) {
 void uci_uci(void) {
     printf("id name Ryska\n");
     printf("id author Sooryashankar Joy\n");
-    printf("option name Hash type spin default 32 min 1 max 1024\n");
-    printf("option name Threads type spin default 1 min 1 max 8\n");
+    printf("option name Hash type spin default %d min 1 max 1024\n", TT_DEFAULT_MB);
+    printf("option name HashFile type string default hash.bin\n");
+    printf("option name Threads type spin default 1 min 1 max %d\n", MAX_THREADS);
+    printf("option name Deterministic type check default false\n");
+    printf("option name Ponder type check default false\n");
     printf("uciok\n");
     fflush(stdout);
 }
@@ -130,10 +295,9 @@ void uci_uci(void) {
 // Respond to isready command
 void uci_isready(void) {
     if (!engine_ready) {
-        // Initialize engine components
-        init_bitboards();
-        init_evaluation_tables();
-        board_init(&current_board);
+        // Tables are compiled in; only the opening book is loaded here
+        printf("info string cpu %s kernels %s\n", cpu_feature_string(), bitboard_kernel_string());
+        printf("info string hash %zu MB pages %s\n", tt_size_mb(), tt_page_string());
         // Try to load default book file
         book_clear();
         int loaded = book_load("book.txt");
@@ -149,6 +313,8 @@ void uci_isready(void) {
 // Respond to newgame command
 void uci_newgame(void) {
     board_init(&current_board);
+    tt_clear();
+    search_clear_history();
 }
 
 // Parse position command
@@ -200,13 +366,71 @@ void uci_position(const char* command) {
     // Optional debug removed for performance
 }
 
+// Body of the search thread: search, then report the move
+static void* search_main(void* arg) {
+    (void)arg;
+    const Board* board = &search_job.board;
+    SearchResult result = iterative_deepening(board, search_job.depth, &search_job.tc);
+
+    // An infinite or ponder search that runs out of depth still waits to be
+    // told to stop (or, when pondering, for ponderhit)
+    pthread_mutex_lock(&search_lock);
+    while (!stop_search && (search_job.tc.infinite || search_pondering)) {
+        pthread_cond_wait(&search_stopped, &search_lock);
+    }
+    pthread_mutex_unlock(&search_lock);
+
+    // Check if the move is legal (our movegen only returns legal moves)
+    Move legal_moves[256];
+    int legal_count = generate_moves(board, legal_moves);
+    // Pick the PV move if it exists in the legal move list
+    int found = 0;
+    for (int i = 0; i < legal_count; i++) {
+        if (move_equal(result.best_move, legal_moves[i])) { found = 1; break; }
+    }
+    char move[6];
+    if (found) {
+        // Final evaluation string
+        move_to_string(result.best_move, move);
+        printf("info string finaleval %+.2f\n", result.score / 100.0);
+        // The reply the search expects comes second in its PV
+        if (result.pv_length > 1) {
+            char ponder[6];
+            move_to_string(result.pv[1], ponder);
+            printf("bestmove %s ponder %s\n", move, ponder);
+        } else {
+            printf("bestmove %s\n", move);
+        }
+    } else if (legal_count > 0) {
+        // Fallback: output first legal move if any (all moves from generate_moves are legal)
+        int cp = evaluate_position(board);
+        move_to_string(legal_moves[0], move);
+        printf("info string finaleval %+.2f\n", cp / 100.0);
+        printf("bestmove %s\n", move);
+    } else {
+        printf("bestmove 0000\n");
+    }
+    fflush(stdout);
+
+    pthread_mutex_lock(&search_lock);
+    search_running = 0;
+    pthread_mutex_unlock(&search_lock);
+    return NULL;
+}
+
 // Parse go command and start search
 void uci_go(const char* command) {
-    int depth = 6;
+    int depth = 0;
     int movetime = 0;
     int wtime = 0, btime = 0, winc = 0, binc = 0, movestogo = 0, nodes = 0, mate = 0, infinite = 0;
     char searchmoves[256] = "";
     int ponder = 0;
+    // "go perft N" counts moves instead of searching
+    const char* perft_arg = strstr(command, "perft");
+    if (perft_arg) {
+        uci_perft(perft_arg + 5);
+        return;
+    }
     // Parse all go options
     const char* p = command;
     while (*p) {
@@ -227,6 +451,12 @@ void uci_go(const char* command) {
         } else if (strncmp(p, "ponder", 6) == 0) { ponder = 1; p += 6; }
         else { p++; }
     }
+    // Without a depth, clock and node limits end the search; with neither, depth 6 does
+    if (depth <= 0) {
+        depth = (movetime || wtime || btime || nodes || infinite) ? MAX_DEPTH - 1 : 6;
+    }
+    // The PV and search stack hold MAX_DEPTH plies, so deeper requests are capped
+    if (depth > MAX_DEPTH - 1) depth = MAX_DEPTH - 1;
     // Opening book
     const char* bookmove = own_book ? book_get_move(last_moves_string) : NULL;
     if (bookmove) {
@@ -245,46 +475,66 @@ void uci_go(const char* command) {
         }
         // fallthrough: ignore invalid book move for this position
     }
-    // Search (interruptible, info lines)
-    SearchResult result;
-    int nodes_searched = 0;
-    int start_time = 0; // TODO: use real time
-    for (int d = 1; d <= depth && !stop_search; d++) {
-        result = search_position(&current_board, d);
-        nodes_searched += result.nodes;
-        printf("info depth %d score cp %d nodes %d pv ", d, result.score, nodes_searched);
-        print_move(result.best_move); printf("\n");
-        fflush(stdout);
-        // Human-friendly decimal eval line
-        printf("info string eval %+.2f\n", result.score / 100.0);
-        fflush(stdout);
-        // TODO: add time, nps, pv, etc.
-        if (movetime > 0 && d * 100 > movetime) break; // crude time control
-    }
-    // Check if the move is legal (our movegen only returns legal moves)
-    Move legal_moves[256];
-    int legal_count = generate_moves(&current_board, legal_moves);
-    // Pick the PV move if it exists in the legal move list
-    int found = 0;
-    for (int i = 0; i < legal_count; i++) {
-        if (move_equal(result.best_move, legal_moves[i])) { found = 1; break; }
-    }
-    if (found) {
-        // Final evaluation string
-        printf("info string finaleval %+.2f\n", result.score / 100.0);
-        printf("bestmove "); print_move(result.best_move); printf("\n"); fflush(stdout);
+    // Search on all threads; entries from earlier searches become replaceable
+    tt_age();
+    search_job.board = current_board;
+    search_job.depth = depth;
+    TimeControl* tc = &search_job.tc;
+    init_time_control(tc);
+    tc->wtime = wtime;
+    tc->btime = btime;
+    tc->winc = winc;
+    tc->binc = binc;
+    tc->movestogo = movestogo;
+    tc->depth = depth;
+    tc->nodes = nodes;
+    tc->movetime = movetime;
+    tc->infinite = infinite;
+
+    pthread_mutex_lock(&search_lock);
+    search_clear_abort();
+    search_set_ponder(ponder);
+    search_pondering = ponder;
+    stop_search = 0;
+    search_running = 1;
+    pthread_mutex_unlock(&search_lock);
+
+    if (pthread_create(&search_thread, NULL, search_main, NULL) == 0) {
+        search_thread_joinable = 1;
     } else {
-        // Fallback: output first legal move if any (all moves from generate_moves are legal)
-        if (legal_count > 0) {
-            int cp = evaluate_position(&current_board);
-            printf("info string finaleval %+.2f\n", cp / 100.0);
-            printf("bestmove "); print_move(legal_moves[0]); printf("\n"); fflush(stdout);
-            return;
-        }
-        printf("bestmove 0000\n"); fflush(stdout);
+        search_main(NULL);
     }
 }
 
+// Perft/divide: "perft <depth> [threads <n>] [hash <mb>]"
+// Threads defaults to the Threads option; the perft hash is off unless given
+void uci_perft(const char* args) {
+    int depth = atoi(args);
+    int threads = thread_count;
+    int hash_mb = 0;
+    const char* p;
+    if ((p = strstr(args, "threads")) != NULL) threads = atoi(p + 7);
+    if ((p = strstr(args, "hash")) != NULL) hash_mb = atoi(p + 4);
+    if (depth < 1) depth = 1;
+
+    Move moves[MAX_MOVES];
+    uint64_t counts[MAX_MOVES];
+    long start = perft_time_ms();
+    int count = perft_divide(&current_board, depth, threads, (size_t)hash_mb, moves, counts);
+    long elapsed = perft_time_ms() - start;
+
+    uint64_t total = 0;
+    for (int i = 0; i < count; i++) {
+        print_move(moves[i]);
+        printf(": %llu\n", (unsigned long long)counts[i]);
+        total += counts[i];
+    }
+    printf("\nNodes searched: %llu\n", (unsigned long long)total);
+    printf("info string perft depth %d nodes %llu time %ld Mnps %.2f\n", depth,
+           (unsigned long long)total, elapsed, elapsed > 0 ? total / (elapsed * 1000.0) : 0.0);
+    fflush(stdout);
+}
+
 // Pure parser for UCI move string (no board state)
 Move parse_move(const char* move_str) {
     if (strlen(move_str) < 4) return NULL_MOVE;
@@ -363,47 +613,82 @@ Move parse_move(const char* move_str) {
 }
 
 // Print move in UCI format
-void print_move(Move move) {
+void move_to_string(Move move, char* str) {
     if (move_equal(move, NULL_MOVE)) {
-        printf("0000");
+        strcpy(str, "0000");
         return;
     }
     
     Square from = move_from(move);
     Square to = move_to(move);
     
-    File from_file = file_of(from);
-    Rank from_rank = rank_of(from);
-    File to_file = file_of(to);
-    Rank to_rank = rank_of(to);
-    
-    printf("%c%c%c%c", 
-           'a' + from_file, '1' + from_rank,
-           'a' + to_file, '1' + to_rank);
+    str[0] = 'a' + file_of(from);
+    str[1] = '1' + rank_of(from);
+    str[2] = 'a' + file_of(to);
+    str[3] = '1' + rank_of(to);
+    str[4] = 0;
     
     // Add promotion piece if applicable
     if (is_promotion(move)) {
-        PieceType promo = promotion_piece(move);
-        switch (promo) {
-            case KNIGHT: printf("n"); break;
-            case BISHOP: printf("b"); break;
-            case ROOK: printf("r"); break;
-            case QUEEN: printf("q"); break;
+        switch (promotion_piece(move)) {
+            case KNIGHT: str[4] = 'n'; break;
+            case BISHOP: str[4] = 'b'; break;
+            case ROOK: str[4] = 'r'; break;
+            case QUEEN: str[4] = 'q'; break;
             default: break;
         }
+        str[5] = 0;
+    }
+}
+
+void print_move(Move move) {
+    char str[6];
+    move_to_string(move, str);
+    printf("%s", str);
+}
+
+// Reason shown when saving or loading the hash file fails
+static const char* tt_file_error(TTFileResult result) {
+    switch (result) {
+        case TT_FILE_IO_ERROR:     return "cannot access file";
+        case TT_FILE_BAD_FORMAT:   return "not a hash file for this version";
+        case TT_FILE_KEY_MISMATCH: return "saved with different Zobrist keys";
+        case TT_FILE_OK:           break;
     }
+    return "ok";
+}
+
+// Write the transposition table to the HashFile option's path
+void uci_savehash(void) {
+    TTFileResult result = tt_save(hash_file);
+    if (result == TT_FILE_OK) printf("info string hash saved to %s (%zu MB)\n", hash_file, tt_size_mb());
+    else printf("info string hash not saved to %s: %s\n", hash_file, tt_file_error(result));
+    fflush(stdout);
+}
+
+// Replace the transposition table with the one saved at HashFile; Hash becomes its size
+void uci_loadhash(void) {
+    TTFileResult result = tt_load(hash_file);
+    if (result == TT_FILE_OK) {
+        hash_size_mb = (int)tt_size_mb();
+        printf("info string hash loaded from %s (%d MB pages %s)\n", hash_file, hash_size_mb, tt_page_string());
+    } else {
+        printf("info string hash not loaded from %s: %s\n", hash_file, tt_file_error(result));
+    }
+    fflush(stdout);
 }
 
 // Quit the engine
 void uci_quit(void) {
+    interrupt_search();
+    wait_for_search();
     exit(0);
 }
 
-// Stop the search (not implemented in this simple version)
+// Stop the search; its bestmove is printed before this returns
 void uci_stop(void) {
-    stop_search = 1;
-    printf("info string Search stopped\n");
-    fflush(stdout);
+    interrupt_search();
+    wait_for_search();
 }
 
 // Print UCI info
@@ -424,10 +709,26 @@ void uci_setoption(const char* command) {
         while (*value && isspace(*value)) value++;
         val = atoi(value);
     }
-    if (strncasecmp(name, "hash", 4) == 0) {
-        if (val > 0) hash_size_mb = val;
+    if (strncasecmp(name, "hashfile", 8) == 0) {
+        if (value && *value) {
+            strncpy(hash_file, value, sizeof(hash_file) - 1);
+            hash_file[sizeof(hash_file) - 1] = 0;
+        }
+    } else if (strncasecmp(name, "hash", 4) == 0) {
+        if (val > 0 && val != hash_size_mb) {
+            if (tt_resize(val) == 0) {
+                hash_size_mb = val;
+                printf("info string hash %zu MB pages %s\n", tt_size_mb(), tt_page_string());
+            } else {
+                printf("info string cannot allocate %d MB hash, keeping %d MB\n", val, hash_size_mb);
+            }
+        }
     } else if (strncasecmp(name, "ownbook", 7) == 0) {
         own_book = val;
+    } else if (strncasecmp(name, "threads", 7) == 0) {
+        if (val > 0) thread_count = search_set_threads(val);
+    } else if (strncasecmp(name, "deterministic", 13) == 0) {
+        search_set_deterministic(value && strncasecmp(value, "true", 4) == 0);
     }
     // Accept all options, even if not used
 }
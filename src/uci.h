@@ -13,9 +13,13 @@ void uci_position(const char* command);
 void uci_go(const char* command);
 void uci_quit(void);
 void uci_stop(void);
+void uci_perft(const char* args);
+void uci_savehash(void);
+void uci_loadhash(void);
 
 // Move parsing
 Move parse_move(const char* move_str);
+void move_to_string(Move move, char* str);  // str holds at least 6 chars
 void print_move(Move move);
 
 // UCI info
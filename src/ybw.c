@@ -0,0 +1,193 @@
+#include "ybw.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdint.h>
+#include <string.h>
+
+// Moves of one node handed out as tasks. It lives in the owner's stack frame
+// and is published on the owner's worker stack until every task is done.
+typedef struct SplitPoint {
+    const SearchThread* owner;   // Context at the node; untouched until the join
+    struct SplitPoint* parent;   // Split point the owner context is a task of
+    int depth;
+    int ply;
+    int alpha;
+    int beta;
+    const Move* moves;
+    int* scores;
+    int count;
+    int next;                    // Next unclaimed task
+    int done;                    // Finished tasks
+    uint64_t nodes;              // Nodes searched by finished tasks
+} SplitPoint;
+
+// Split points a worker has published, oldest first. Each nests inside the
+// one before it, so at most one per ply.
+typedef struct {
+    pthread_mutex_t lock;
+    SplitPoint* splits[MAX_DEPTH + 1];
+    int count;
+} WorkerStack;
+
+static WorkerStack worker_stacks[MAX_THREADS];
+static pthread_t workers[MAX_THREADS];
+static int worker_count = 1;
+
+// Idle workers sleep until a split point is published or the pool shuts down
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_wake = PTHREAD_COND_INITIALIZER;
+static unsigned long pool_posted;
+static int pool_quit;
+
+// Whether sp nests, at any depth, inside the tasks of within
+static int is_below(const SplitPoint* sp, const SplitPoint* within) {
+    for (sp = sp->parent; sp; sp = sp->parent) {
+        if (sp == within) return 1;
+    }
+    return 0;
+}
+
+static int claim(SplitPoint* sp) {
+    int index = __atomic_fetch_add(&sp->next, 1, __ATOMIC_RELAXED);
+    return index < sp->count ? index : -1;
+}
+
+// Search one move in a fresh copy of the owner's context
+static void run_task(SplitPoint* sp, int index, int worker) {
+    const SearchThread* owner = sp->owner;
+    SearchThread context;
+    context.board = owner->board;
+    memcpy(context.history, owner->history, sizeof(context.history));
+    memcpy(context.countermoves, owner->countermoves, sizeof(context.countermoves));
+    context.continuation = owner->continuation;
+    memcpy(context.stack, owner->stack, sizeof(context.stack));
+    context.id = worker;
+    context.split = sp;
+    context.follow_pv = 0;
+    context.null_min_ply = owner->null_min_ply;
+    context.null_color = owner->null_color;
+#ifdef TT_VERIFY
+    context.verifying = owner->verifying;
+#endif
+    context.nodes = 0;
+
+    sp->scores[index] = search_move(&context, sp->moves[index], sp->depth, sp->ply, sp->alpha, sp->beta, 0);
+
+    __atomic_fetch_add(&sp->nodes, context.nodes, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&sp->done, 1, __ATOMIC_RELEASE);
+}
+
+// Take a task from the oldest split point of another worker, limited to
+// those below within when given. Claiming under the stack's lock keeps the
+// split point alive: its owner unpublishes it under the same lock.
+static int steal(int worker, const SplitPoint* within) {
+    for (int w = 0; w < worker_count; w++) {
+        if (w == worker) continue;
+        WorkerStack* stack = &worker_stacks[w];
+        pthread_mutex_lock(&stack->lock);
+        for (int i = 0; i < stack->count; i++) {
+            SplitPoint* sp = stack->splits[i];
+            if (within && !is_below(sp, within)) continue;
+            int index = claim(sp);
+            if (index >= 0) {
+                pthread_mutex_unlock(&stack->lock);
+                run_task(sp, index, worker);
+                return 1;
+            }
+        }
+        pthread_mutex_unlock(&stack->lock);
+    }
+    return 0;
+}
+
+static void* worker_main(void* arg) {
+    int worker = (int)(intptr_t)arg;
+    for (;;) {
+        pthread_mutex_lock(&pool_lock);
+        unsigned long seen = pool_posted;
+        int quit = pool_quit;
+        pthread_mutex_unlock(&pool_lock);
+        if (quit) break;
+
+        if (steal(worker, NULL)) continue;
+
+        pthread_mutex_lock(&pool_lock);
+        while (pool_posted == seen && !pool_quit) {
+            pthread_cond_wait(&pool_wake, &pool_lock);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+    return NULL;
+}
+
+int ybw_start(int threads) {
+    for (int i = 0; i < threads; i++) {
+        pthread_mutex_init(&worker_stacks[i].lock, NULL);
+        worker_stacks[i].count = 0;
+    }
+    pool_quit = 0;
+    worker_count = 1;
+    while (worker_count < threads) {
+        if (pthread_create(&workers[worker_count], NULL, worker_main, (void*)(intptr_t)worker_count) != 0) break;
+        worker_count++;
+    }
+    return worker_count;
+}
+
+void ybw_stop(void) {
+    pthread_mutex_lock(&pool_lock);
+    pool_quit = 1;
+    pthread_cond_broadcast(&pool_wake);
+    pthread_mutex_unlock(&pool_lock);
+    for (int i = 1; i < worker_count; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    for (int i = 0; i < worker_count; i++) {
+        pthread_mutex_destroy(&worker_stacks[i].lock);
+    }
+    worker_count = 1;
+}
+
+uint64_t ybw_search_moves(SearchThread* thread, int depth, int ply, int alpha, int beta,
+                          const Move* moves, int count, int* scores) {
+    SplitPoint sp;
+    sp.owner = thread;
+    sp.parent = thread->split;
+    sp.depth = depth;
+    sp.ply = ply;
+    sp.alpha = alpha;
+    sp.beta = beta;
+    sp.moves = moves;
+    sp.scores = scores;
+    sp.count = count;
+    sp.next = 0;
+    sp.done = 0;
+    sp.nodes = 0;
+
+    WorkerStack* stack = &worker_stacks[thread->id];
+    pthread_mutex_lock(&stack->lock);
+    stack->splits[stack->count++] = &sp;
+    pthread_mutex_unlock(&stack->lock);
+
+    if (worker_count > 1) {
+        pthread_mutex_lock(&pool_lock);
+        pool_posted++;
+        pthread_cond_broadcast(&pool_wake);
+        pthread_mutex_unlock(&pool_lock);
+    }
+
+    // The owner works through its own tasks first, then helps whoever took
+    // the rest until they are all in
+    int index;
+    while ((index = claim(&sp)) >= 0) {
+        run_task(&sp, index, thread->id);
+    }
+    while (__atomic_load_n(&sp.done, __ATOMIC_ACQUIRE) < count) {
+        if (!steal(thread->id, &sp)) sched_yield();
+    }
+
+    pthread_mutex_lock(&stack->lock);
+    stack->count--;
+    pthread_mutex_unlock(&stack->lock);
+    return sp.nodes;
+}
@@ -0,0 +1,33 @@
+#ifndef YBW_H
+#define YBW_H
+
+#include "search.h"
+
+// Nodes at least this deep split the moves left after the first few
+#define YBW_SPLIT_DEPTH 3
+#define YBW_SPLIT_AFTER 2
+
+// Young Brothers Wait: once a node's first moves have been searched without
+// a cutoff, the remaining ones become tasks that any worker may take. Every
+// task is scouted with a null window at the node's alpha at that point, in a
+// fresh copy of the node's ordering state, so no result depends on which
+// thread ran it or when. The node then goes through the scores in move
+// order and searches again, itself, any move that beat the scout.
+//
+// Each worker keeps its split points on a stack of its own; idle workers
+// steal from the bottom of another worker's stack, where the largest
+// subtrees are. A worker waiting for its tasks helps only below them.
+
+// Start workers 1..threads-1; worker 0 is the caller's thread
+int ybw_start(int threads);
+
+// Wake and join the workers
+void ybw_stop(void);
+
+// Search moves[0..count) of thread's current position with the window
+// (alpha, beta), writing each score from the node's point of view.
+// Returns the nodes the tasks searched.
+uint64_t ybw_search_moves(SearchThread* thread, int depth, int ply, int alpha, int beta,
+                          const Move* moves, int count, int* scores);
+
+#endif // YBW_H
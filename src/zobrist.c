@@ -0,0 +1,32 @@
+#include "zobrist.h"
+
+// Generate Zobrist hash for a position
+uint64_t generate_hash(const Board* board) {
+    uint64_t hash = 0;
+    
+    // Hash pieces
+    for (Color c = WHITE; c < COLOR_COUNT; c++) {
+        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
+            Bitboard pieces = board->pieces[c][pt];
+            while (pieces) {
+                Square sq = pop_lsb(&pieces);
+                hash ^= zobrist_pieces[c][pt][sq];
+            }
+        }
+    }
+    
+    // Hash side to move
+    if (board->side_to_move == BLACK) {
+        hash ^= zobrist_side;
+    }
+    
+    // Hash castling rights
+    hash ^= zobrist_castling[board->castling_rights];
+    
+    // Hash en passant square
+    if (board->en_passant != A1) {
+        hash ^= zobrist_ep[board->en_passant];
+    }
+    
+    return hash;
+}
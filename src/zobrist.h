@@ -0,0 +1,21 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include "constants.h"
+#include "board.h"
+#include <stdint.h>
+
+// Seed for the Zobrist key generator in tools/gentables.c (changing it
+// invalidates stored hashes)
+#define ZOBRIST_SEED 0x52795A4B6F627269ULL
+
+// Zobrist keys (generated at build time)
+extern const uint64_t zobrist_pieces[2][6][64];
+extern const uint64_t zobrist_side;
+extern const uint64_t zobrist_castling[16];
+extern const uint64_t zobrist_ep[64];
+
+// Full recomputation of a position's key
+uint64_t generate_hash(const Board* board);
+
+#endif // ZOBRIST_H
@@ -5,7 +5,6 @@
 
 int main() {
     init_bitboards();
-    init_evaluation_tables();
     
     Board board;
     board_init(&board);
@@ -0,0 +1,387 @@
+// Build-time table generator: computes every precomputed table the engine
+// uses and prints them as const C arrays (the Makefile writes obj/tables.c).
+// Nothing here is linked into the engine.
+
+#include "../src/constants.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+typedef uint64_t Bitboard;
+
+// Must match ZOBRIST_SEED in zobrist.h (the generated file checks this)
+#define ZOBRIST_SEED 0x52795A4B6F627269ULL
+
+static Bitboard rank_bb[8];
+static Bitboard file_bb[8];
+static Bitboard square_bb[64];
+static Bitboard knight_attacks[64];
+static Bitboard king_attacks[64];
+static Bitboard pawn_attacks[2][64];
+static Bitboard between_bb[64][64];
+static Bitboard line_bb[64][64];
+
+typedef struct {
+    Bitboard mask;
+    Bitboard magic;
+    unsigned offset;
+    int shift;
+} Magic;
+
+static Magic bishop_magics[64];
+static Magic rook_magics[64];
+static Bitboard bishop_attack_table[0x1480];
+static Bitboard rook_attack_table[0x19000];
+static Bitboard bishop_pext_table[0x1480];
+static Bitboard rook_pext_table[0x19000];
+
+static int pawn_table[64];
+static int knight_table[64];
+static int bishop_table[64];
+static int rook_table[64];
+static int queen_table[64];
+static int king_table[64];
+static int knight_mobility_bonus[9];
+static int bishop_mobility_bonus[14];
+static int rook_mobility_bonus[15];
+static int queen_mobility_bonus[28];
+
+static uint64_t zobrist_pieces[2][6][64];
+static uint64_t zobrist_side;
+static uint64_t zobrist_castling[16];
+static uint64_t zobrist_ep[64];
+
+static const int bishop_directions[4][2] = { {1, 1}, {-1, 1}, {1, -1}, {-1, -1} };
+static const int rook_directions[4][2] = { {0, 1}, {0, -1}, {1, 0}, {-1, 0} };
+
+static int pop_count(Bitboard bb) {
+    int count = 0;
+    while (bb) {
+        count++;
+        bb &= bb - 1;
+    }
+    return count;
+}
+
+static Bitboard shift_north(Bitboard bb)     { return bb << 8; }
+static Bitboard shift_south(Bitboard bb)     { return bb >> 8; }
+static Bitboard shift_east(Bitboard bb)      { return (bb << 1) & ~FILE_A_BB; }
+static Bitboard shift_west(Bitboard bb)      { return (bb >> 1) & ~FILE_H_BB; }
+static Bitboard shift_northeast(Bitboard bb) { return (bb << 9) & ~FILE_A_BB; }
+static Bitboard shift_northwest(Bitboard bb) { return (bb << 7) & ~FILE_H_BB; }
+static Bitboard shift_southeast(Bitboard bb) { return (bb >> 7) & ~FILE_A_BB; }
+static Bitboard shift_southwest(Bitboard bb) { return (bb >> 9) & ~FILE_H_BB; }
+
+// Ray-walk attacks for a slider
+static Bitboard sliding_attacks(const int directions[4][2], Square sq, Bitboard occupied) {
+    Bitboard attacks = 0;
+    for (int d = 0; d < 4; d++) {
+        int f = (int)file_of(sq) + directions[d][0];
+        int r = (int)rank_of(sq) + directions[d][1];
+        while (f >= 0 && f < 8 && r >= 0 && r < 8) {
+            Bitboard bb = 1ULL << (r * 8 + f);
+            attacks |= bb;
+            if (occupied & bb) break;
+            f += directions[d][0];
+            r += directions[d][1];
+        }
+    }
+    return attacks;
+}
+
+// xorshift64* generator; AND-ing three draws gives the sparse candidates magics need
+static Bitboard sparse_random(uint64_t* state) {
+    Bitboard r = ~0ULL;
+    for (int i = 0; i < 3; i++) {
+        *state ^= *state >> 12;
+        *state ^= *state << 25;
+        *state ^= *state >> 27;
+        r &= *state * 2685821657736338717ULL;
+    }
+    return r;
+}
+
+// Find a magic for every square and fill its slice of both attack tables.
+// Carry-Rippler visits the subsets in the order of their PEXT index, so the
+// PEXT slice is simply the reference attacks in enumeration order.
+static void init_magics(Magic* magics, Bitboard* table, Bitboard* pext_table, const int directions[4][2]) {
+    static Bitboard occupancy[4096];
+    static Bitboard reference[4096];
+    static int epoch[4096];
+    // Per-rank seeds known to converge quickly with this generator
+    static const uint64_t seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    int attempt = 0;
+    unsigned offset = 0;
+
+    memset(epoch, 0, sizeof(epoch));
+    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
+        Magic* m = &magics[sq];
+        Bitboard edges = ((RANK_1_BB | RANK_8_BB) & ~rank_bb[rank_of(sq)]) |
+                         ((FILE_A_BB | FILE_H_BB) & ~file_bb[file_of(sq)]);
+        m->mask = sliding_attacks(directions, sq, 0) & ~edges;
+        m->shift = 64 - pop_count(m->mask);
+        m->offset = offset;
+
+        // Enumerate every subset of the mask (Carry-Rippler)
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancy[size] = subset;
+            reference[size] = sliding_attacks(directions, sq, subset);
+            size++;
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+        memcpy(pext_table + offset, reference, (size_t)size * sizeof(Bitboard));
+
+        // Try candidates until one maps every subset without a destructive collision
+        Bitboard* attacks = table + offset;
+        uint64_t seed = seeds[rank_of(sq)];
+        for (int i = 0; i < size; ) {
+            do {
+                m->magic = sparse_random(&seed);
+            } while (pop_count((m->mask * m->magic) >> 56) < 6);
+            attempt++;
+            for (i = 0; i < size; i++) {
+                unsigned index = (unsigned)((occupancy[i] * m->magic) >> m->shift);
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    attacks[index] = reference[i];
+                } else if (attacks[index] != reference[i]) {
+                    break;
+                }
+            }
+        }
+        offset += (unsigned)size;
+    }
+}
+
+static void init_bitboards(void) {
+    for (int i = 0; i < 8; i++) {
+        rank_bb[i] = RANK_1_BB << (8 * i);
+        file_bb[i] = FILE_A_BB << i;
+    }
+
+    for (int i = 0; i < 64; i++) {
+        square_bb[i] = 1ULL << i;
+    }
+
+    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
+        Bitboard bb = square_bb[sq];
+        knight_attacks[sq] =
+            shift_north(shift_northeast(bb)) | shift_north(shift_northwest(bb)) |  // 2 up, 1 left/right
+            shift_south(shift_southeast(bb)) | shift_south(shift_southwest(bb)) |  // 2 down, 1 left/right
+            shift_east(shift_northeast(bb)) | shift_east(shift_southeast(bb)) |    // 2 right, 1 up/down
+            shift_west(shift_northwest(bb)) | shift_west(shift_southwest(bb));     // 2 left, 1 up/down
+        king_attacks[sq] =
+            shift_north(bb) | shift_south(bb) | shift_east(bb) | shift_west(bb) |
+            shift_northeast(bb) | shift_northwest(bb) | shift_southeast(bb) | shift_southwest(bb);
+        pawn_attacks[WHITE][sq] = shift_northeast(bb) | shift_northwest(bb);
+        pawn_attacks[BLACK][sq] = shift_southeast(bb) | shift_southwest(bb);
+    }
+
+    init_magics(bishop_magics, bishop_attack_table, bishop_pext_table, bishop_directions);
+    init_magics(rook_magics, rook_attack_table, rook_pext_table, rook_directions);
+
+    // Between/line tables for aligned square pairs
+    for (Square s1 = A1; s1 < SQUARE_COUNT; s1++) {
+        for (Square s2 = A1; s2 < SQUARE_COUNT; s2++) {
+            if (s1 == s2) continue;
+            const int (*dirs)[2] = NULL;
+            if (sliding_attacks(bishop_directions, s1, 0) & square_bb[s2]) dirs = bishop_directions;
+            else if (sliding_attacks(rook_directions, s1, 0) & square_bb[s2]) dirs = rook_directions;
+            if (!dirs) continue;
+            line_bb[s1][s2] = (sliding_attacks(dirs, s1, 0) & sliding_attacks(dirs, s2, 0)) | square_bb[s1] | square_bb[s2];
+            between_bb[s1][s2] = sliding_attacks(dirs, s1, square_bb[s2]) & sliding_attacks(dirs, s2, square_bb[s1]);
+        }
+    }
+}
+
+static void init_evaluation_tables(void) {
+    for (int i = 0; i < 64; i++) {
+        Rank r = rank_of(i);
+        File f = file_of(i);
+        int center = r >= RANK_3 && r <= RANK_6 && f >= FILE_C && f <= FILE_F;
+        int bonus;
+
+        // Pawn table - encourage center pawns and pawn advancement
+        bonus = 0;
+        if (f >= FILE_C && f <= FILE_F) bonus += 10;
+        if (r >= RANK_4 && r <= RANK_6) bonus += 5;
+        if (r >= RANK_5) bonus += 10;
+        pawn_table[i] = bonus;
+
+        // Knight table - encourage knights in the center
+        bonus = 0;
+        if (center) bonus += 10;
+        if (r == RANK_1 || r == RANK_8 || f == FILE_A || f == FILE_H) bonus -= 5;
+        knight_table[i] = bonus;
+
+        // Bishop table - encourage bishops on long diagonals
+        bonus = 0;
+        if (center) bonus += 5;
+        bishop_table[i] = bonus;
+
+        // Rook table - encourage rooks on open files and 7th rank
+        bonus = 0;
+        if (r == RANK_7) bonus += 20;
+        if (f >= FILE_C && f <= FILE_F) bonus += 5;
+        rook_table[i] = bonus;
+
+        // Queen table - encourage queen in the center
+        queen_table[i] = center ? 5 : 0;
+
+        // King table - encourage king safety
+        bonus = 0;
+        if (center) bonus -= 10;
+        if ((r == RANK_1 || r == RANK_8) && (f == FILE_G || f == FILE_C)) bonus += 20;
+        king_table[i] = bonus;
+    }
+
+    for (int i = 0; i < 9; i++) knight_mobility_bonus[i] = i * 3;
+    for (int i = 0; i < 14; i++) bishop_mobility_bonus[i] = i * 2;
+    for (int i = 0; i < 15; i++) rook_mobility_bonus[i] = i * 2;
+    for (int i = 0; i < 28; i++) queen_mobility_bonus[i] = i;
+}
+
+// SplitMix64: full 64-bit output with good avalanche, unlike a plain LCG
+static uint64_t splitmix64(uint64_t* state) {
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static void init_zobrist_keys(void) {
+    uint64_t seed = ZOBRIST_SEED;
+
+    for (Color c = WHITE; c < COLOR_COUNT; c++) {
+        for (PieceType pt = PAWN; pt < PIECE_COUNT; pt++) {
+            for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
+                zobrist_pieces[c][pt][sq] = splitmix64(&seed);
+            }
+        }
+    }
+
+    zobrist_side = splitmix64(&seed);
+
+    for (int i = 0; i < 16; i++) {
+        zobrist_castling[i] = splitmix64(&seed);
+    }
+
+    for (Square sq = A1; sq < SQUARE_COUNT; sq++) {
+        zobrist_ep[sq] = splitmix64(&seed);
+    }
+}
+
+// Print 'count' values as a brace list, four per line
+static void emit_u64(const uint64_t* values, int count, int indent) {
+    printf("{");
+    for (int i = 0; i < count; i++) {
+        if (i % 4 == 0) printf("\n%*s", indent + 4, "");
+        else printf(" ");
+        printf("0x%016llXULL%s", (unsigned long long)values[i], i + 1 < count ? "," : "");
+    }
+    printf("\n%*s}", indent, "");
+}
+
+static void emit_int(const int* values, int count) {
+    printf("{");
+    for (int i = 0; i < count; i++) {
+        if (i % 16 == 0) printf("\n    ");
+        else printf(" ");
+        printf("%d%s", values[i], i + 1 < count ? "," : "");
+    }
+    printf("\n}");
+}
+
+static void emit_u64_table(const char* decl, const uint64_t* values, int count) {
+    printf("const %s = ", decl);
+    emit_u64(values, count, 0);
+    printf(";\n\n");
+}
+
+// Two-dimensional table: 'rows' brace lists of 'cols' values
+static void emit_u64_table2(const char* decl, const uint64_t* values, int rows, int cols) {
+    printf("const %s = {", decl);
+    for (int r = 0; r < rows; r++) {
+        printf("\n    ");
+        emit_u64(values + (size_t)r * cols, cols, 4);
+        printf("%s", r + 1 < rows ? "," : "");
+    }
+    printf("\n};\n\n");
+}
+
+static void emit_zobrist_pieces(void) {
+    printf("const uint64_t zobrist_pieces[2][6][64] = {");
+    for (int c = 0; c < 2; c++) {
+        printf("\n    {");
+        for (int pt = 0; pt < 6; pt++) {
+            printf("\n        ");
+            emit_u64(zobrist_pieces[c][pt], 64, 8);
+            printf("%s", pt < 5 ? "," : "");
+        }
+        printf("\n    }%s", c < 1 ? "," : "");
+    }
+    printf("\n};\n\n");
+}
+
+static void emit_int_table(const char* decl, const int* values, int count) {
+    printf("const %s = ", decl);
+    emit_int(values, count);
+    printf(";\n\n");
+}
+
+static void emit_magics(const char* name, const Magic* magics) {
+    printf("const Magic %s[64] = {\n", name);
+    for (int sq = 0; sq < 64; sq++) {
+        printf("    { 0x%016llXULL, 0x%016llXULL, %u, %d }%s\n",
+               (unsigned long long)magics[sq].mask, (unsigned long long)magics[sq].magic,
+               magics[sq].offset, magics[sq].shift, sq < 63 ? "," : "");
+    }
+    printf("};\n\n");
+}
+
+int main(void) {
+    init_bitboards();
+    init_evaluation_tables();
+    init_zobrist_keys();
+
+    printf("// Generated by tools/gentables.c at build time - do not edit\n\n");
+    printf("#include \"bitboard.h\"\n#include \"evaluation.h\"\n#include \"zobrist.h\"\n\n");
+    printf("#if ZOBRIST_SEED != 0x%016llXULL\n#error \"ZOBRIST_SEED differs from tools/gentables.c\"\n#endif\n\n",
+           (unsigned long long)ZOBRIST_SEED);
+
+    emit_u64_table("Bitboard rank_bb[8]", rank_bb, 8);
+    emit_u64_table("Bitboard file_bb[8]", file_bb, 8);
+    emit_u64_table("Bitboard square_bb[64]", square_bb, 64);
+    emit_u64_table("Bitboard knight_attacks[64]", knight_attacks, 64);
+    emit_u64_table("Bitboard king_attacks[64]", king_attacks, 64);
+    emit_u64_table2("Bitboard pawn_attacks[2][64]", &pawn_attacks[0][0], 2, 64);
+    emit_u64_table2("Bitboard between_bb[64][64]", &between_bb[0][0], 64, 64);
+    emit_u64_table2("Bitboard line_bb[64][64]", &line_bb[0][0], 64, 64);
+
+    emit_magics("bishop_magics", bishop_magics);
+    emit_magics("rook_magics", rook_magics);
+    emit_u64_table("Bitboard bishop_attack_table[0x1480]", bishop_attack_table, 0x1480);
+    emit_u64_table("Bitboard rook_attack_table[0x19000]", rook_attack_table, 0x19000);
+    emit_u64_table("Bitboard bishop_pext_table[0x1480]", bishop_pext_table, 0x1480);
+    emit_u64_table("Bitboard rook_pext_table[0x19000]", rook_pext_table, 0x19000);
+
+    emit_int_table("int pawn_table[64]", pawn_table, 64);
+    emit_int_table("int knight_table[64]", knight_table, 64);
+    emit_int_table("int bishop_table[64]", bishop_table, 64);
+    emit_int_table("int rook_table[64]", rook_table, 64);
+    emit_int_table("int queen_table[64]", queen_table, 64);
+    emit_int_table("int king_table[64]", king_table, 64);
+    emit_int_table("int knight_mobility_bonus[9]", knight_mobility_bonus, 9);
+    emit_int_table("int bishop_mobility_bonus[14]", bishop_mobility_bonus, 14);
+    emit_int_table("int rook_mobility_bonus[15]", rook_mobility_bonus, 15);
+    emit_int_table("int queen_mobility_bonus[28]", queen_mobility_bonus, 28);
+
+    emit_zobrist_pieces();
+    printf("const uint64_t zobrist_side = 0x%016llXULL;\n\n", (unsigned long long)zobrist_side);
+    emit_u64_table("uint64_t zobrist_castling[16]", zobrist_castling, 16);
+    emit_u64_table("uint64_t zobrist_ep[64]", zobrist_ep, 64);
+
+    return 0;
+}